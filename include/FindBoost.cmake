@@ -1,4 +1,4 @@
-# Find BOOST library and its components
+# Find BOOST library and its components, link them to the TARGET_NAME target
 find_package(Boost COMPONENTS iostreams thread REQUIRED)
 if (NOT Boost_FOUND)
     message(FATAL_ERROR "Failed to find boost library")
@@ -11,13 +11,13 @@ endif()
 message(${Boost_IOSTREAMS_LIBRARY})
 message(${Boost_THREAD_LIBRARY})
 
-include_directories(${PROJECT_NAME} PRIVATE ${Boost_INCLUDE_DIRS})
+include_directories(${TARGET_NAME} PRIVATE ${Boost_INCLUDE_DIRS})
 
-target_link_libraries(${PROJECT_NAME} PRIVATE
+target_link_libraries(${TARGET_NAME} PRIVATE
         ${Boost_IOSTREAMS_LIBRARY}
         ${Boost_THREAD_LIBRARY})
 
-target_compile_definitions(${PROJECT_NAME} PRIVATE
+target_compile_definitions(${TARGET_NAME} PRIVATE
         BOOST_ALL_NO_LIB
         BOOST_TEST_MODULE=unit-cpp
         USE_BOOST_PREBUILT_STATIC_LIBRARY=false
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <stdexcept>
+#include <type_traits>
+
+#include <boost/asio/strand.hpp>
+
+#include "utils/boost_include.h"
+
+namespace btree::async {
+    using Strand = basio::strand<basio::thread_pool::executor_type>;
+
+    /**
+     * Library-owned thread pool for the async volume API:
+     *  - every volume has its own strand, so the operations of one volume are queued and run one by one
+     *    without a lock, the operations of different volumes run in parallel
+     *  - the pool is started by the first async operation with configure(...) threads (all cores by default)
+     */
+    class Executor final {
+        basio::thread_pool pool;
+
+        inline static std::atomic<size_t> thread_count = 0;
+        inline static std::atomic<bool> is_started = false;
+
+        explicit Executor(const size_t thread_count) : pool(thread_count) {}
+    public:
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        /** Has to be called before the first async operation */
+        static void configure(const size_t threads) {
+            if (is_started)
+                throw std::logic_error("The executor is already started");
+            thread_count = threads;
+        }
+
+        static Executor& instance() {
+            // never destroyed: the static storages can wait for their operations after the exit from main
+            static auto* executor = [] {
+                is_started = true;
+                auto threads = thread_count.load();
+                return new Executor(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+            }();
+            return *executor;
+        }
+
+        Strand make_strand() {
+            return basio::make_strand(pool.get_executor());
+        }
+
+        /** Queues fn() to the strand, the future holds the result or the thrown exception */
+        template <typename Fn>
+        static auto submit(Strand& strand, Fn&& fn) -> std::future<std::invoke_result_t<Fn&>> {
+            using R = std::invoke_result_t<Fn&>;
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+            auto future = task->get_future();
+            basio::post(strand, [task] { (*task)(); });
+            return future;
+        }
+    };
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "utils/utils.h"
+#include "utils/forward_decl.h"
+
+namespace btree {
+    /**
+     * Batched point lookups with interleaved prefetching (AMAC, "asynchronous memory access chaining"):
+     *  - every lookup is a small state machine, a step reads the data prefetched by the previous step of the lookup,
+     *    prefetches the data of its next step and yields to the next lookup of the group
+     *  - the group of lookups is processed round-robin, so the cache misses of the lookups overlap
+     *    instead of the serial misses of the tree descent: node field -> entry KEY -> node field of the child -> ...
+     *  - a finished lookup is replaced with the next KEY of the batch
+     * The result is the same as BTreeNode::find(...) of every KEY: the KEY of the node is found first,
+     * then the pending message of the node, then the KEY is looked for in the child.
+     */
+    template <typename K, typename V>
+    class BatchLookup final {
+        using IOManagerT = IOManager<K, V>;
+
+        static constexpr int32_t group_size = 16;
+
+        enum class Stage : uint8_t {
+            READ_NODE,      // the used keys of the node are prefetched
+            READ_KEY_POS,   // the KEY_POS[mid] of the node is prefetched
+            COMPARE_KEY,    // the KEY of the entry at KEY_POS[mid] is prefetched
+            READ_CHILD_POS, // the CHILD_POS[idx] of the node is prefetched
+            DONE
+        };
+
+        struct Lookup {
+            size_t idx = 0;
+            Stage stage = Stage::DONE;
+            int64_t node_pos = IOManagerT::INVALID_POS;
+            bool is_leaf = false;
+            int32_t left = 0;
+            int32_t right = -1;
+            int32_t mid = 0;
+            int64_t entry_pos = IOManagerT::INVALID_POS;
+        };
+
+        IOManagerT& io;
+        const int64_t root_pos;
+        const bool has_buffers;
+    public:
+        BatchLookup(IOManagerT& io, const int64_t root_pos, const bool has_buffers) :
+            io(io), root_pos(root_pos), has_buffers(has_buffers) {}
+
+        /** Returns the entry positions of the keys in the same order, INVALID_POS if there is no such KEY */
+        std::vector<int64_t> find(const std::vector<K>& keys) {
+            std::vector<int64_t> entries(keys.size(), IOManagerT::INVALID_POS);
+            if (root_pos == IOManagerT::INVALID_POS)
+                return entries;
+
+            std::array<Lookup, group_size> group;
+            size_t next = 0;
+            int32_t active = 0;
+            for (auto& lookup: group) {
+                if (next < keys.size()) {
+                    start(lookup, next++);
+                    ++active;
+                }
+            }
+
+            while (active > 0) {
+                // the prefetches of the last round are one batch of reads for the explicit I/O backend
+                io.submit_prefetches();
+                for (auto& lookup: group) {
+                    if (lookup.stage == Stage::DONE)
+                        continue;
+                    step(lookup, keys[lookup.idx], entries[lookup.idx]);
+                    if (lookup.stage != Stage::DONE)
+                        continue;
+                    if (next < keys.size())
+                        start(lookup, next++);
+                    else
+                        --active;
+                }
+            }
+            return entries;
+        }
+
+    private:
+        void start(Lookup& lookup, const size_t idx) {
+            lookup.idx = idx;
+            go_to_node(lookup, root_pos);
+        }
+
+        void go_to_node(Lookup& lookup, const int64_t node_pos) {
+            lookup.node_pos = node_pos;
+            lookup.stage = Stage::READ_NODE;
+            io.prefetch(node_pos);
+        }
+
+        void step(Lookup& lookup, const K key, int64_t& result) {
+            switch (lookup.stage) {
+                case Stage::READ_NODE:
+                    lookup.is_leaf = io.template read_at<uint8_t>(lookup.node_pos);
+                    if (!lookup.is_leaf)
+                        io.keep_internal_node(lookup.node_pos);
+                    lookup.left = 0;
+                    lookup.right = io.template read_at<int16_t>(io.used_keys_pos(lookup.node_pos)) - 1;
+                    probe(lookup, key, result);
+                    break;
+                case Stage::READ_KEY_POS:
+                    lookup.entry_pos = io.read_entry_pos_at(io.key_pos_pos(lookup.node_pos, lookup.mid));
+                    lookup.stage = Stage::COMPARE_KEY;
+                    io.prefetch(lookup.entry_pos);
+                    break;
+                case Stage::COMPARE_KEY: {
+                    auto curr_key = io.read_key(lookup.entry_pos);
+                    if (curr_key == key) {
+                        result = lookup.entry_pos;
+                        lookup.stage = Stage::DONE;
+                        break;
+                    }
+                    if (curr_key < key)
+                        lookup.left = lookup.mid + 1;
+                    else
+                        lookup.right = lookup.mid - 1;
+                    probe(lookup, key, result);
+                    break;
+                }
+                case Stage::READ_CHILD_POS:
+                    go_to_node(lookup, io.read_child_pos_at(io.child_pos_pos(lookup.node_pos, lookup.left)));
+                    break;
+                case Stage::DONE:
+                    break;
+            }
+        }
+
+        /** The next step of the binary search in the node, or the way down when the KEY isn't in the node */
+        void probe(Lookup& lookup, const K key, int64_t& result) {
+            if (lookup.left <= lookup.right) {
+                lookup.mid = lookup.left + (lookup.right - lookup.left) / 2;
+                lookup.stage = Stage::READ_KEY_POS;
+                io.prefetch(io.key_pos_pos(lookup.node_pos, lookup.mid));
+                return;
+            }
+
+            if (lookup.is_leaf) {
+                lookup.stage = Stage::DONE;
+                return;
+            }
+            if (has_buffers) {
+                auto msg_pos = find_message(lookup.node_pos, key);
+                if (msg_pos != IOManagerT::INVALID_POS) {
+                    result = msg_pos;
+                    lookup.stage = Stage::DONE;
+                    return;
+                }
+            }
+            // the KEY is between KEY_POS[left - 1] and KEY_POS[left]
+            lookup.stage = Stage::READ_CHILD_POS;
+            io.prefetch(io.child_pos_pos(lookup.node_pos, lookup.left));
+        }
+
+        /** The buffers are small and sorted, so the message is looked for without prefetching */
+        int64_t find_message(const int64_t node_pos, const K key) {
+            int32_t left = 0;
+            int32_t right = io.template read_at<int16_t>(io.msg_count_pos(node_pos)) - 1;
+            while (left <= right) {
+                auto mid = left + (right - left) / 2;
+                auto msg_key = io.template read_at<K>(io.msg_key_pos(node_pos, mid));
+                if (msg_key < key)
+                    left = mid + 1;
+                else if (msg_key > key)
+                    right = mid - 1;
+                else
+                    return io.read_entry_pos_at(io.msg_pos_pos(node_pos, mid));
+            }
+            return IOManagerT::INVALID_POS;
+        }
+    };
+}
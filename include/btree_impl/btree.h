@@ -3,9 +3,11 @@
 #include <type_traits>
 #include <cstdint>
 #include <optional>
+#include <limits>
 
 #include "entry.h"
 #include "btree_node.h"
+#include "batch_lookup.h"
 #include "utils/forward_decl.h"
 
 namespace btree {
@@ -21,17 +23,64 @@ namespace btree {
         using Node = BTreeNode<K, V>;
         using IOManagerT = IOManager<K, V>;
 
-        BTree(const int16_t order, IOManagerT& io);
+        /** The orders of the nodes are the orders of IO (see IOManager::order) */
+        BTree(const int16_t buffer_size, IOManagerT& io);
 
         bool exist(IOManagerT& io, const K key) const;
         std::optional<V> get(IOManagerT& io, const K key) const;
-        void set(IOManagerT& io, const K key, ValueType value);
-        void set(IOManagerT& io, const K key, const V& value, const int32_t size);
+        /** Returns the invalid entry if there is no such KEY */
+        EntryT find(IOManagerT& io, const K key) const;
+        /**
+         * Looks for the keys at once with interleaved prefetching (see BatchLookup) and calls fn(idx, entry)
+         * for every KEY in the order of keys, the entry is invalid if there is no such KEY
+         */
+        template <typename Fn>
+        void find(IOManagerT& io, const std::vector<K>& keys, Fn&& fn) const;
+        /** Returns the entry positions of the keys in the same order, INVALID_POS if there is no such KEY */
+        std::vector<int64_t> find_entry_pos(IOManagerT& io, const std::vector<K>& keys) const;
+
+        /** Returns the position of the entry that holds the value for the KEY */
+        int64_t set(IOManagerT& io, const K key, ValueType value);
+        int64_t set(IOManagerT& io, const K key, const V& value, const int32_t size);
+        int64_t set(IOManagerT& io, const EntryT& e);
+        /** Points the KEY to the entry written at ENTRY_POS, the tree with the node buffers gets the message */
+        void set_entry_pos(IOManagerT& io, const K key, const int64_t entry_pos);
+        /**
+         * Read-modify-write of the KEY with one traversal: fn(entry) gets the entry of the KEY (invalid if there is
+         * no such KEY) and returns the new entry or nullopt to keep the old one. Returns the position of the written
+         * entry or INVALID_POS if nothing is written. The tree with the node buffers looks for the KEY first.
+         */
+        template <typename Fn>
+        int64_t update(IOManagerT& io, const K key, Fn&& fn);
         bool remove(IOManagerT& io, const K key);
+
+        /** Calls fn(entry_pos) for every entry in the ascending order of keys */
+        template <typename Fn>
+        void traverse(IOManagerT& io, Fn&& fn);
+
+        /**
+         * Calls fn(entry_pos) for every entry with FROM <= KEY <= TO in the ascending order of keys,
+         * stops if fn returns false
+         */
+        template <typename Fn>
+        void traverse(IOManagerT& io, const K from, const K to, Fn&& fn);
+
+        /** Applies the pending messages of the internal nodes to the tree */
+        void flush_messages(IOManagerT& io);
     private:
-        void insert(IOManagerT& io, const EntryT& e);
+        int64_t insert(IOManagerT& io, const EntryT& e);
+        void insert(IOManagerT& io, const K key, const int64_t entry_pos);
+        int64_t put_message(IOManagerT& io, const EntryT& e);
+        void put_message(IOManagerT& io, const K key, const int64_t entry_pos);
+        /** Flushes the full root buffer or splits the full root */
+        void make_room_for_message(IOManagerT& io);
+        void split_root(IOManagerT& io);
+        /** Looks at the buffers of the opened volume once: the volume without the messages isn't flushed */
+        bool has_pending_messages(IOManagerT& io);
 
-        const int16_t t;
+        const int16_t b;
+        // false if all the buffers are empty, nullopt until the buffers of the opened volume are looked at
+        std::optional<bool> has_messages;
         BTreeNode<K, V> root;
     };
 }
@@ -2,7 +2,9 @@
 
 namespace btree {
     template <typename K, typename V>
-    BTree<K, V>::BTree(const int16_t order, IOManagerT& io) : t(order), root() {
+    BTree<K, V>::BTree(const int16_t buffer_size, IOManagerT& io) :
+        b(buffer_size), has_messages(false), root()
+    {
         if (!io.is_ready())
             return;
 
@@ -11,28 +13,86 @@ namespace btree {
             return;
 
         root = io.read_node(root_pos);
+        if (b > 0)
+            has_messages = std::nullopt;
     }
 
     template <typename K, typename V>
-    void BTree<K, V>::set(IOManagerT& io, const K key, ValueType value) {
+    int64_t BTree<K, V>::set(IOManagerT& io, const K key, ValueType value) {
         EntryT e{ key, value };
-        if (!root.is_valid() || !root.set(io, e))
-            insert(io, e);
+        return set(io, e);
     }
 
     template <typename K, typename V>
-    void BTree<K, V>::set(IOManagerT& io, const K key, const V& value, const int32_t size) {
-        if (size != 0) {
-            EntryT e{ key, value, size };
-            if (!root.is_valid() || !root.set(io, e))
-                insert(io, e);
+    int64_t BTree<K, V>::set(IOManagerT& io, const K key, const V& value, const int32_t size) {
+        if (size == 0)
+            return IOManagerT::INVALID_POS;
+
+        EntryT e{ key, value, size };
+        return set(io, e);
+    }
+
+    template <typename K, typename V>
+    int64_t BTree<K, V>::set(IOManagerT& io, const EntryT& e) {
+        if (root.has_buffer())
+            return put_message(io, e);
+
+        int64_t pos = root.is_valid() ? root.set(io, e) : IOManagerT::INVALID_POS;
+        return (pos != IOManagerT::INVALID_POS) ? pos : insert(io, e);
+    }
+
+    template <typename K, typename V>
+    void BTree<K, V>::set_entry_pos(IOManagerT& io, const K key, const int64_t entry_pos) {
+        if (root.has_buffer())
+            put_message(io, key, entry_pos);
+        else if (!root.set_entry_pos(io, key, entry_pos))
+            insert(io, key, entry_pos);
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    int64_t BTree<K, V>::update(IOManagerT& io, const K key, Fn&& fn) {
+        if (root.is_valid() && !root.has_buffer()) {
+            bool is_found = false;
+            auto pos = root.update(io, key, [&is_found, &fn](const EntryT& entry) {
+                is_found = true;
+                return fn(entry);
+            });
+            if (is_found)
+                return pos;
         }
+
+        // there is no such KEY in the plain tree, the buffered one may have the KEY in the pending messages
+        const std::optional<EntryT> e = fn(root.has_buffer() ? find(io, key) : EntryT{});
+        if (!e)
+            return IOManagerT::INVALID_POS;
+        return root.has_buffer() ? put_message(io, *e) : insert(io, *e);
     }
 
     template <typename K, typename V>
     std::optional<V> BTree<K, V>::get(IOManagerT& io, const K key) const {
-        EntryT res = root.is_valid() ? root.find(io, key) : EntryT{};
-        return res.value();
+        return find(io, key).value();
+    }
+
+    template <typename K, typename V>
+    typename BTree<K, V>::EntryT BTree<K, V>::find(IOManagerT& io, const K key) const {
+        return root.is_valid() ? root.find(io, key) : EntryT{};
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    void BTree<K, V>::find(IOManagerT& io, const std::vector<K>& keys, Fn&& fn) const {
+        auto entry_pos = find_entry_pos(io, keys);
+
+        // the entry is passed to fn right away: the value may be valid until the next reads only (see PositionalFile)
+        for (size_t i = 0; i < entry_pos.size(); ++i)
+            fn(i, entry_pos[i] == IOManagerT::INVALID_POS ? EntryT() : io.read_entry(entry_pos[i]));
+    }
+
+    template <typename K, typename V>
+    std::vector<int64_t> BTree<K, V>::find_entry_pos(IOManagerT& io, const std::vector<K>& keys) const {
+        auto root_pos = root.is_valid() ? root.m_pos : IOManagerT::INVALID_POS;
+        return BatchLookup<K, V>(io, root_pos, b > 0).find(keys);
     }
 
     template <typename K, typename V>
@@ -41,9 +101,63 @@ namespace btree {
         return success;
     }
 
+    template <typename K, typename V>
+    int64_t BTree<K, V>::put_message(IOManagerT& io, const EntryT& e) {
+        // The blind upsert: the message goes to the root buffer without looking for the KEY in the tree
+        make_room_for_message(io);
+        auto entry_pos = io.allocate_entry(e);
+        io.write_entry(e, entry_pos);
+        put_message(io, e.key, entry_pos);
+        return entry_pos;
+    }
+
+    template <typename K, typename V>
+    void BTree<K, V>::put_message(IOManagerT& io, const K key, const int64_t entry_pos) {
+        make_room_for_message(io);
+        root.put_message(io, key, entry_pos);
+        io.write_node(root, root.m_pos);
+        has_messages = true;
+    }
+
+    template <typename K, typename V>
+    void BTree<K, V>::make_room_for_message(IOManagerT& io) {
+        if (root.is_buffer_full()) {
+            if (root.is_full())
+                split_root(io);
+            else
+                root.flush(io);
+        }
+    }
+
+    template <typename K, typename V>
+    void BTree<K, V>::flush_messages(IOManagerT& io) {
+        if (!has_pending_messages(io))
+            return;
+
+        std::map<K, int64_t> messages;
+        if (root.is_valid())
+            root.collect_messages(io, messages);
+        for (const auto& [key, entry_pos]: messages) {
+            if (!root.set_entry_pos(io, key, entry_pos))
+                insert(io, key, entry_pos);
+        }
+        has_messages = false;
+    }
+
+    template <typename K, typename V>
+    bool BTree<K, V>::has_pending_messages(IOManagerT& io) {
+        if (!has_messages)
+            has_messages = root.is_valid() && root.has_messages(io);
+        return *has_messages;
+    }
+
     template <typename K, typename V>
     bool BTree<K, V>::remove(IOManagerT& io, const K key) {
-        bool success = root.is_valid() && root.remove(io, key);
+        // The removal rebalances the nodes on the path of the KEY: their pending messages are taken out of the buffers
+        // and put again after the removal, the messages of the KEY are dropped
+        std::map<K, int64_t> messages;
+        bool success = root.is_valid() && root.remove(io, key, has_pending_messages(io) ? &messages : nullptr);
+        success |= (messages.erase(key) > 0);
 
         if (success && root.used_keys == 0) {
             if (root.is_leaf) {
@@ -56,52 +170,71 @@ namespace btree {
             }
         }
 
+        // the taken messages go through the root again, the rebalanced nodes route them by their new keys
+        for (const auto& [message_key, entry_pos]: messages)
+            set_entry_pos(io, message_key, entry_pos);
         return success;
     }
 
     template <typename K, typename V>
-    void BTree<K, V>::insert(IOManagerT& io, const EntryT& e) {
+    template <typename Fn>
+    void BTree<K, V>::traverse(IOManagerT& io, Fn&& fn) {
+        traverse(io, std::numeric_limits<K>::min(), std::numeric_limits<K>::max(), fn);
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    void BTree<K, V>::traverse(IOManagerT& io, const K from, const K to, Fn&& fn) {
+        flush_messages(io);
+        if (root.is_valid() && from <= to)
+            root.traverse(io, from, to, fn);
+    }
+
+    template <typename K, typename V>
+    int64_t BTree<K, V>::insert(IOManagerT& io, const EntryT& e) {
         if (!root.is_valid()) {
             // write header
             auto root_pos = io.write_header();
 
-            root = Node(t, true);
+            root = Node(io.order(true), true, b);
             root.m_pos = root_pos;
             root.used_keys++;
 
-            auto entry_pos = root.m_pos + Node::get_node_size_in_bytes(t);
+            // the root may be in the node file, so the entry is allocated after the root is written
+            io.write_node(root, root.m_pos);
+            auto entry_pos = io.allocate_entry(e);
             root.key_pos[0] = entry_pos;
 
-            // write node root and key|value
-            io.write_node(root, root.m_pos);
+            // write key|value and node root: the leaf with the inline values copies the entry
             io.write_entry(e, entry_pos);
+            io.write_node(root, root.m_pos);
+            return entry_pos;
         } else {
-            if (root.is_full()) {
-                Node newRoot(t, false);
-                newRoot.child_pos[0] = root.m_pos;
-
-                // Write node
-                newRoot.m_pos = io.get_file_pos_end();
-                io.write_node(newRoot, newRoot.m_pos);
+            auto entry_pos = io.allocate_entry(e);
+            io.write_entry(e, entry_pos);
+            insert(io, e.key, entry_pos);
+            return entry_pos;
+        }
+    }
 
-                newRoot.split_child(io, 0, root);
+    template <typename K, typename V>
+    void BTree<K, V>::insert(IOManagerT& io, const K key, const int64_t entry_pos) {
+        if (root.is_full())
+            split_root(io);
+        root.insert_non_full(io, key, entry_pos);
+    }
 
-                // Find the child have new key
-                int32_t i = 0;
-                K root_key = newRoot.get_key(io, 0);
-                if (root_key < e.key)
-                    i++;
+    template <typename K, typename V>
+    void BTree<K, V>::split_root(IOManagerT& io) {
+        Node new_root(io.order(false), false, b);
+        new_root.child_pos[0] = root.m_pos;
 
-                // Read node
-                auto pos = newRoot.child_pos[i];
-                Node node = io.read_node(pos);
-                node.insert_non_full(io, e);
+        // Write node
+        new_root.m_pos = io.allocate_node(false);
+        io.write_node(new_root, new_root.m_pos);
 
-                root = io.read_node(newRoot.m_pos);
-                io.write_new_pos_for_root_node(newRoot.m_pos);
-            } else {
-                root.insert_non_full(io, e);
-            }
-        }
+        new_root.split_child(io, 0, root);
+        io.write_new_pos_for_root_node(new_root.m_pos);
+        root = std::move(new_root);
     }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <tuple>
 #include <vector>
 
 #include "utils/forward_decl.h"
@@ -14,15 +16,58 @@ namespace btree {
         std::vector<int64_t> key_pos;
         std::vector<int64_t> child_pos;
 
+        // Buffer of pending upsert messages { KEY -> entry pos } sorted by KEY (only for internal nodes if b > 0).
+        // A message is newer than anything in the subtree below and never refers to a key of the node itself.
+        int16_t b;
+        int16_t msg_count;
+        std::vector<K> msg_keys;
+        std::vector<int64_t> msg_pos;
+
+        // The copies of the entries at KEY_POS kept by the leaf of the volume with the inline values, the copy is used
+        // only if its pos matches KEY_POS[i]. IOManager::write_node refreshes them, so they're mutable.
+        struct InlineEntry {
+            int64_t pos;
+            K key;
+            int64_t expires_at;
+            conditional_t<std::is_arithmetic_v<V>, V, int64_t> value;
+        };
+        mutable std::vector<InlineEntry> inline_entries;
+
+        // The frame of reference of the keys of the inline entries kept by the leaf of the volume with the compressed
+        // keys: KEY[i] is BASE + the WIDTH-byte delta i, so the search in the leaf compares the packed deltas.
+        // WIDTH is 0 if the keys don't fit. IOManager::write_node refreshes it with the inline entries.
+        struct KeyFrame {
+            K base = K();
+            uint8_t width = 0;
+            std::vector<uint8_t> deltas;
+
+            K key(const int32_t idx) const;
+            /** The index of the first key that isn't less than KEY */
+            int32_t lower_bound(const K key) const;
+        };
+        mutable KeyFrame key_frame;
+
         using Node = BTreeNode;
         using EntryT = typename BTree<K,V>::EntryT;
         using IOManagerT = IOManager<K, V>;
 
         explicit BTreeNode();
-        BTreeNode(const int16_t& t, bool isLeaf);
-
-        bool set(IOManagerT& io_manager, const EntryT& e);
-        bool remove(IOManagerT& io_manager, const K key);
+        BTreeNode(const int16_t& t, bool isLeaf, const int16_t b = 0);
+
+        int64_t set(IOManagerT& io_manager, const EntryT& e);
+        /**
+         * Calls fn(entry) for the existing KEY and writes the entry fn returns like set(...) does,
+         * returns INVALID_POS if there is no such KEY in the tree or fn returned nullopt
+         */
+        template <typename Fn>
+        int64_t update(IOManagerT& io_manager, const K key, Fn&& fn);
+        /** Points the existing KEY to the entry, returns false if there is no such KEY in the tree */
+        bool set_entry_pos(IOManagerT& io_manager, const K key, const int64_t entry_pos);
+        /**
+         * The tree with the node buffers passes TAKEN_MESSAGES: the nodes that the removal may rebalance (the nodes
+         * on the way down and their children next to the way) move their messages there, the newest one of every KEY
+         */
+        bool remove(IOManagerT& io_manager, const K key, std::map<K, int64_t>* taken_messages = nullptr);
 
         EntryT find(IOManagerT& io_manager, const K key) const;
         K get_key(IOManagerT& io_manager, const int32_t idx) const;
@@ -30,21 +75,47 @@ namespace btree {
         static constexpr int32_t get_node_size_in_bytes(const int16_t t);
         bool is_full() const;
         bool is_valid() const;
+        bool has_buffer() const;
+        bool is_buffer_full() const;
 
         void split_child(IOManagerT& manager, const int32_t idx, BTreeNode& curr_node);
-        void insert_non_full(IOManagerT& io_manager, const EntryT& e);
+        void insert_non_full(IOManagerT& io_manager, const K key, const int64_t entry_pos);
+
+        /** Updates the KEY of the node in place or buffers the message, the buffer mustn't be full */
+        void put_message(IOManagerT& io_manager, const K key, const int64_t entry_pos);
+        /** Pushes the biggest batch of messages down to the child, the node mustn't be full */
+        void flush(IOManagerT& io_manager);
+        /** Moves the messages of the subtree to the map: the newest message of every KEY is kept */
+        void collect_messages(IOManagerT& io_manager, std::map<K, int64_t>& messages);
+        /** Any internal node of the subtree has the pending messages, the leaves aren't read */
+        bool has_messages(IOManagerT& io_manager) const;
+
+        /** Returns false if the traversal is over: the key greater than TO is met or fn returned false */
+        template <typename Fn>
+        bool traverse(IOManagerT& io_manager, const K from, const K to, Fn& fn) const;
     private:
         static constexpr int32_t max_key_num(const int16_t t);
         static constexpr int32_t max_child_num(const int16_t t);
 
         int32_t find_key_bin_search(IOManagerT& io_manager, const K key) const;
+        /** All the keys of the node are in the key frame */
+        bool has_key_frame() const;
+        int32_t find_message(const K key) const;
+        std::pair<int32_t, int32_t> find_batch(IOManagerT& io_manager, const int32_t idx) const;
+        std::tuple<int32_t, int32_t, int32_t> find_biggest_batch(IOManagerT& io_manager) const;
+        bool set_in_leaf(IOManagerT& io_manager, const K key, const int64_t entry_pos);
+        void erase_messages(const int32_t from, const int32_t to);
         std::tuple<BTreeNode, EntryT, int32_t> find_leaf_node_with_key(IOManagerT& io_manager, const K key) const;
 
         EntryT get_entry(IOManagerT& io_manager, const int32_t idx) const;
+        bool has_inline_entry(const int32_t idx) const;
         BTreeNode get_child(IOManagerT& io_manager, const int32_t idx) const;
 
         bool remove_from_leaf(IOManagerT& io_manager, const int32_t idx);
-        bool remove_from_non_leaf(IOManagerT& io_manager, const int32_t idx);
+        bool remove_from_non_leaf(IOManagerT& io_manager, const int32_t idx, std::map<K, int64_t>* taken_messages);
+        /** Moves the messages of the node and its children [IDX - 1, IDX + 1] to the map */
+        void take_messages(IOManagerT& io_manager, const int32_t idx, std::map<K, int64_t>& messages);
+        void take_own_messages(IOManagerT& io_manager, std::map<K, int64_t>& messages);
 
         int64_t get_prev_entry_pos(IOManagerT& io_manager, const int32_t idx) const;
         int64_t get_next_entry_pos(IOManagerT& io_manager, const int32_t idx) const;
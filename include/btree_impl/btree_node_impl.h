@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+
 #include "utils/utils.h"
 
 namespace btree {
@@ -12,16 +15,22 @@ namespace btree {
             is_leaf(false),
             m_pos(-1),
             key_pos(0, -1),
-            child_pos(0, -1) {}
+            child_pos(0, -1),
+            b(0),
+            msg_count(0) {}
 
     template <typename K, typename V>
-    BTreeNode<K, V>::BTreeNode(const int16_t& t, bool is_leaf) :
+    BTreeNode<K, V>::BTreeNode(const int16_t& t, bool is_leaf, const int16_t b) :
             used_keys(0),
             t(t),
             is_leaf(is_leaf),
             m_pos(-1),
             key_pos(max_key_num(t), -1),
-            child_pos(max_child_num(t), -1) {}
+            child_pos(max_child_num(t), -1),
+            b(b),
+            msg_count(0),
+            msg_keys(has_buffer() ? b : 0, K(-1)),
+            msg_pos(has_buffer() ? b : 0, -1) {}
 
     template <typename K, typename V>
     bool BTreeNode<K, V>::is_full() const {
@@ -33,6 +42,16 @@ namespace btree {
         return t != 0;
     }
 
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::has_buffer() const {
+        return !is_leaf && (b > 0);
+    }
+
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::is_buffer_full() const {
+        return has_buffer() && (msg_count == b);
+    }
+
     template <typename K, typename V>
     constexpr int32_t BTreeNode<K,V>::get_node_size_in_bytes(const int16_t t) {
         static_assert(std::is_same_v<decltype(m_pos), typename decltype(key_pos)::value_type>);
@@ -46,29 +65,44 @@ namespace btree {
 
     template <typename K, typename V>
     void BTreeNode<K, V>::split_child(IOManagerT& manager, const int32_t idx, Node& curr_node) {
+        // the order of the child: the leaves and the internal nodes may have the different orders
+        const auto ct = curr_node.t;
         // Create a new node to store (t-1) keys of divided node
-        Node new_node(curr_node.t, curr_node.is_leaf);
-        new_node.used_keys = t - 1;
+        Node new_node(curr_node.t, curr_node.is_leaf, curr_node.b);
+        new_node.used_keys = ct - 1;
 
         // Copy the last (t-1) keys of divided node to new_node
-        for (auto i = 0; i < t - 1; ++i) {
-            new_node.key_pos[i] = curr_node.key_pos[i + t];
-            curr_node.key_pos[i + t] = -1;
+        for (auto i = 0; i < ct - 1; ++i) {
+            new_node.key_pos[i] = curr_node.key_pos[i + ct];
+            curr_node.key_pos[i + ct] = -1;
         }
         // Copy the last (t-1) children of divided node to new_node
         if (!curr_node.is_leaf) {
-            for (auto i = 0; i < t; ++i) {
-                new_node.child_pos[i] = curr_node.child_pos[i + t];
-                curr_node.child_pos[i + t] = -1;
+            for (auto i = 0; i < ct; ++i) {
+                new_node.child_pos[i] = curr_node.child_pos[i + ct];
+                curr_node.child_pos[i + ct] = -1;
             }
         }
 
-        // write new node
-        new_node.m_pos = manager.get_file_pos_end();
+        // Move the messages greater than the key-divider to new_node (there are no messages for the key-divider)
+        const K divider = has_buffer() ? manager.read_key(curr_node.key_pos[ct - 1]) : K();
+        if (curr_node.has_buffer()) {
+            auto from = curr_node.find_message(divider);
+            for (auto i = from; i < curr_node.msg_count; ++i) {
+                new_node.msg_keys[i - from] = curr_node.msg_keys[i];
+                new_node.msg_pos[i - from] = curr_node.msg_pos[i];
+            }
+            new_node.msg_count = curr_node.msg_count - from;
+            curr_node.msg_count = from;
+        }
+
+        // write new node, the leaf reuses the copies of the entries (see IOManager::write_node)
+        new_node.inline_entries = curr_node.inline_entries;
+        new_node.m_pos = manager.allocate_node(new_node.is_leaf);
         manager.write_node(new_node, new_node.m_pos);
 
         // write current node
-        curr_node.used_keys = t - 1;
+        curr_node.used_keys = ct - 1;
         manager.write_node(curr_node, curr_node.m_pos);
 
         // Shift children, keys and values to right
@@ -76,10 +110,19 @@ namespace btree {
         shift_right_by_one(key_pos, used_keys, idx);
 
         // set the key-divider
-        key_pos[idx] = curr_node.key_pos[t - 1];
+        key_pos[idx] = curr_node.key_pos[ct - 1];
         child_pos[idx + 1] = new_node.m_pos;
         ++used_keys;
 
+        // The pending message for the key-divider is newer than the key-divider itself
+        if (has_buffer()) {
+            auto m = find_message(divider);
+            if (m < msg_count && msg_keys[m] == divider) {
+                key_pos[idx] = msg_pos[m];
+                erase_messages(m, m + 1);
+            }
+        }
+
         // write node
         manager.write_node(*this, m_pos);
     }
@@ -89,6 +132,8 @@ namespace btree {
         if (idx < 0 || idx > used_keys - 1)
             return IOManagerT::INVALID_POS;
 
+        if (has_inline_entry(idx))
+            return inline_entries[idx].key;
         return io.read_key(key_pos[idx]);
     }
 
@@ -97,9 +142,60 @@ namespace btree {
         if (idx < 0 || idx > used_keys - 1)
             return EntryT();
 
+        if constexpr(std::is_arithmetic_v<V>) {
+            if (has_inline_entry(idx)) {
+                const auto& e = inline_entries[idx];
+                return EntryT(e.key, e.value, sizeof(V), e.expires_at);
+            }
+        }
         return io.read_entry(key_pos[idx]);
     }
 
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::has_inline_entry(const int32_t idx) const {
+        return idx < static_cast<int32_t>(inline_entries.size()) && inline_entries[idx].pos == key_pos[idx];
+    }
+
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::has_key_frame() const {
+        if (key_frame.width == 0 || key_frame.deltas.size() != static_cast<size_t>(used_keys) * key_frame.width)
+            return false;
+        for (int32_t i = 0; i < used_keys; ++i) {
+            if (!has_inline_entry(i))
+                return false;
+        }
+        return true;
+    }
+
+    template <typename K, typename V>
+    K BTreeNode<K, V>::KeyFrame::key(const int32_t idx) const {
+        using U = std::make_unsigned_t<K>;
+        auto delta_at = [this, idx](auto delta) {
+            std::memcpy(&delta, deltas.data() + idx * sizeof(delta), sizeof(delta));
+            return static_cast<U>(delta);
+        };
+        const U delta = width == 1 ? delta_at(uint8_t()) : width == 2 ? delta_at(uint16_t()) : delta_at(uint32_t());
+        return static_cast<K>(static_cast<U>(static_cast<U>(base) + delta));
+    }
+
+    template <typename K, typename V>
+    int32_t BTreeNode<K, V>::KeyFrame::lower_bound(const K key) const {
+        using U = std::make_unsigned_t<K>;
+        const auto count = static_cast<int32_t>(deltas.size() / width);
+        if (key < base)
+            return 0;
+
+        const auto delta = static_cast<uint64_t>(static_cast<U>(static_cast<U>(key) - static_cast<U>(base)));
+        switch (width) {
+            case 1:
+                return delta > UINT8_MAX ? count : count_less(deltas.data(), count, static_cast<uint8_t>(delta));
+            case 2:
+                return delta > UINT16_MAX ? count : count_less(deltas.data(), count, static_cast<uint16_t>(delta));
+            default:
+                return delta > UINT32_MAX ? count : count_less(deltas.data(), count, static_cast<uint32_t>(delta));
+        }
+    }
+
     template <typename K, typename V>
     BTreeNode <K, V> BTreeNode<K, V>::get_child(IOManagerT& io, const int32_t idx) const {
         if (idx < 0 || idx > used_keys)
@@ -109,42 +205,220 @@ namespace btree {
     }
 
     template <typename K, typename V>
-    void BTreeNode<K, V>::insert_non_full(IOManagerT& io, const EntryT& e) {
+    void BTreeNode<K, V>::insert_non_full(IOManagerT& io, const K key, const int64_t entry_pos) {
         if (is_leaf) {
             auto idx = used_keys - 1;
             K curr_key = get_key(io, idx);
 
-            while (idx >= 0 && curr_key > e.key) {
+            while (idx >= 0 && curr_key > key) {
                 key_pos[idx + 1] = key_pos[idx];
                 idx--;
                 curr_key = get_key(io, idx);
             }
 
-            auto pos = io.get_file_pos_end(); // go to the end after reading entries
-            key_pos[idx + 1] = pos;
+            key_pos[idx + 1] = entry_pos;
             ++used_keys;
 
-            // Write node and entry
+            // Write node
             io.write_node(*this, m_pos);
-            io.write_entry(e, pos);
         } else {
-            auto idx = find_key_bin_search(io, e.key);
+            auto idx = find_key_bin_search(io, key);
             Node node = get_child(io, idx);
 
             if (node.is_full()) {
                 split_child(io, idx, node);
                 K curr_key = get_key(io, idx);
-                if (curr_key < e.key)
+                if (curr_key < key)
                     idx++;
             }
 
             node = get_child(io, idx);
-            node.insert_non_full(io, e);
+            node.insert_non_full(io, key, entry_pos);
+        }
+    }
+
+    template <typename K, typename V>
+    void BTreeNode<K, V>::put_message(IOManagerT& io, const K key, const int64_t entry_pos) {
+        auto idx = find_key_bin_search(io, key);
+        if (idx < used_keys && get_key(io, idx) == key) {
+            key_pos[idx] = entry_pos;
+            return;
+        }
+
+        auto m = find_message(key);
+        if (m < msg_count && msg_keys[m] == key) {
+            msg_pos[m] = entry_pos;
+            return;
+        }
+
+        shift_right_by_one(msg_keys, msg_count, m);
+        shift_right_by_one(msg_pos, msg_count, m);
+        msg_keys[m] = key;
+        msg_pos[m] = entry_pos;
+        ++msg_count;
+    }
+
+    template <typename K, typename V>
+    void BTreeNode<K, V>::flush(IOManagerT& io) {
+        auto [idx, from, to] = find_biggest_batch(io);
+        Node child = get_child(io, idx);
+
+        // Split the full child in advance like insert_non_full does: the child may need a room for a new key
+        if (child.is_full()) {
+            split_child(io, idx, child);
+            // the batch is divided between the halves, the bigger part is moved
+            auto [left_from, left_to] = find_batch(io, idx);
+            auto [right_from, right_to] = find_batch(io, idx + 1);
+            if (right_to - right_from > left_to - left_from)
+                std::tie(idx, from, to) = std::make_tuple(idx + 1, right_from, right_to);
+            else
+                std::tie(from, to) = std::make_tuple(left_from, left_to);
+            if (from == to)
+                return;
+            child = get_child(io, idx);
+        }
+
+        // The batch is moved until the child is full: the rest waits for the next flush
+        auto moved = from;
+        for (; moved < to; ++moved) {
+            const K key = msg_keys[moved];
+            if (child.is_leaf) {
+                if (!child.set_in_leaf(io, key, msg_pos[moved]))
+                    break;
+            } else {
+                if (child.is_buffer_full()) {
+                    if (child.is_full())
+                        break;
+                    child.flush(io);
+                }
+                child.put_message(io, key, msg_pos[moved]);
+            }
+        }
+
+        io.write_node(child, child.m_pos);
+        erase_messages(from, moved);
+        io.write_node(*this, m_pos);
+    }
+
+    template <typename K, typename V>
+    void BTreeNode<K, V>::collect_messages(IOManagerT& io, std::map<K, int64_t>& messages) {
+        if (is_leaf)
+            return;
+
+        // The parent is visited before the children, so the first message of the KEY is the newest one
+        take_own_messages(io, messages);
+
+        // All the leaves are on the same level, so the leaves aren't read
+        Node child = get_child(io, 0);
+        if (child.is_leaf)
+            return;
+        for (auto i = 0; i <= used_keys; ++i) {
+            child = get_child(io, i);
+            child.collect_messages(io, messages);
+        }
+    }
+
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::has_messages(IOManagerT& io) const {
+        if (is_leaf)
+            return false;
+        if (msg_count > 0)
+            return true;
+
+        // All the leaves are on the same level, so the leaves aren't read
+        if (get_child(io, 0).is_leaf)
+            return false;
+        for (auto i = 0; i <= used_keys; ++i) {
+            if (get_child(io, i).has_messages(io))
+                return true;
         }
+        return false;
+    }
+
+    template <typename K, typename V>
+    int32_t BTreeNode<K, V>::find_message(const K key) const {
+        auto begin = msg_keys.begin();
+        return static_cast<int32_t>(std::lower_bound(begin, begin + msg_count, key) - begin);
+    }
+
+    template <typename K, typename V>
+    std::pair<int32_t, int32_t> BTreeNode<K, V>::find_batch(IOManagerT& io, const int32_t idx) const {
+        // The messages are sorted, so the messages for the child[idx] are between the keys [idx - 1] and [idx]
+        auto from = (idx == 0) ? 0 : find_message(get_key(io, idx - 1));
+        auto to = (idx == used_keys) ? msg_count : find_message(get_key(io, idx));
+        return { from, to };
+    }
+
+    template <typename K, typename V>
+    std::tuple<int32_t, int32_t, int32_t> BTreeNode<K, V>::find_biggest_batch(IOManagerT& io) const {
+        int32_t best_idx = 0, best_from = 0, best_to = 0;
+        for (int32_t i = 0; i <= used_keys; ++i) {
+            auto [from, to] = find_batch(io, i);
+            if (to - from > best_to - best_from)
+                std::tie(best_idx, best_from, best_to) = std::make_tuple(i, from, to);
+            if (to == msg_count)
+                break;
+        }
+        return { best_idx, best_from, best_to };
+    }
+
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::set_in_leaf(IOManagerT& io, const K key, const int64_t entry_pos) {
+        auto idx = find_key_bin_search(io, key);
+        if (idx < used_keys && get_key(io, idx) == key) {
+            key_pos[idx] = entry_pos;
+            return true;
+        }
+        if (is_full())
+            return false;
+
+        shift_right_by_one(key_pos, used_keys, idx);
+        key_pos[idx] = entry_pos;
+        ++used_keys;
+        return true;
+    }
+
+    template <typename K, typename V>
+    void BTreeNode<K, V>::erase_messages(const int32_t from, const int32_t to) {
+        const auto count = to - from;
+        for (auto i = to; i < msg_count; ++i) {
+            msg_keys[i - count] = msg_keys[i];
+            msg_pos[i - count] = msg_pos[i];
+        }
+        msg_count -= count;
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    bool BTreeNode<K, V>::traverse(IOManagerT& io, const K from, const K to, Fn& fn) const {
+        // Skip the keys (and the subtrees on the left of them) that are less than FROM
+        const auto first = find_key_bin_search(io, from);
+
+        // the children and the entries of the node are read in one batch by the explicit I/O backend
+        for (auto i = first; i <= used_keys; ++i) {
+            if (!is_leaf)
+                io.prefetch_node(child_pos[i]);
+            if (i < used_keys)
+                io.prefetch(key_pos[i]);
+        }
+        io.submit_prefetches();
+
+        for (auto i = first; i <= used_keys; ++i) {
+            if (!is_leaf && !get_child(io, i).traverse(io, from, to, fn))
+                return false;
+            if (i == used_keys)
+                break;
+            if (get_key(io, i) > to || !invoke_and_proceed(fn, key_pos[i]))
+                return false;
+        }
+        return true;
     }
 
     template <typename K, typename V>
     int32_t BTreeNode<K, V>::find_key_bin_search(IOManagerT& io, const K key) const {
+        if (has_key_frame())
+            return key_frame.lower_bound(key);
+
         int32_t left = 0;
         int32_t right = used_keys - 1;
         int32_t mid = 0;
@@ -175,6 +449,22 @@ namespace btree {
 
     template <typename K, typename V>
     typename BTree<K,V>::EntryT BTreeNode<K, V>::find(IOManagerT& io, const K key) const {
+        if (b > 0) {
+            // The pending messages on the way down are newer than the keys below them
+            Node curr = *this;
+            while (true) {
+                auto idx = curr.find_key_bin_search(io, key);
+                if (idx < curr.used_keys && curr.get_key(io, idx) == key)
+                    return curr.get_entry(io, idx);
+                if (curr.is_leaf)
+                    return EntryT();
+                auto m = curr.find_message(key);
+                if (m < curr.msg_count && curr.msg_keys[m] == key)
+                    return io.read_entry(curr.msg_pos[m]);
+                curr = curr.get_child(io, idx);
+            }
+        }
+
         const auto&[curr, entry, idx] = find_leaf_node_with_key(io, key);
         if (entry.key == key)
             return entry;
@@ -183,34 +473,69 @@ namespace btree {
     }
 
     template <typename K, typename V>
-    bool BTreeNode<K, V>::set(IOManagerT& io, const EntryT& e) {
-        auto [curr, entry, idx] = find_leaf_node_with_key(io, e.key);
-        if (entry.key == e.key) {
-            if (entry != e) {
-                auto curr_pos = io.get_file_pos_end();
-                curr.key_pos[idx] = curr_pos;
+    int64_t BTreeNode<K, V>::set(IOManagerT& io, const EntryT& e) {
+        return update(io, e.key, [&e](const EntryT&) { return std::optional<EntryT>(e); });
+    }
 
-                io.write_entry(e, curr_pos);
-                io.write_node(curr, curr.m_pos);
-                if (m_pos == curr.m_pos) // curr == this
-                    *this = std::move(curr);
-            }
-            return true;
+    template <typename K, typename V>
+    template <typename Fn>
+    int64_t BTreeNode<K, V>::update(IOManagerT& io, const K key, Fn&& fn) {
+        auto [curr, entry, idx] = find_leaf_node_with_key(io, key);
+        if (entry.key != key)
+            return IOManagerT::INVALID_POS;
+
+        const std::optional<EntryT> e = fn(entry);
+        if (!e)
+            return IOManagerT::INVALID_POS;
+
+        auto curr_pos = curr.key_pos[idx];
+        if (entry == *e)
+            return curr_pos;
+
+        // the value that fits in the old entry doesn't need the new entry and the node write
+        const auto entry_pos = io.overwrite_or_write_entry(*e, curr_pos);
+        if (entry_pos == curr_pos) {
+            if (!curr.is_leaf || !io.has_inline_entries())
+                return curr_pos;
+            io.write_inline_entry(curr, idx, *e);
+        } else {
+            curr_pos = entry_pos;
+            curr.key_pos[idx] = curr_pos;
+            io.write_node(curr, curr.m_pos);
         }
-        return false;
+        if (m_pos == curr.m_pos) // curr == this
+            *this = std::move(curr);
+        return curr_pos;
     }
 
     template <typename K, typename V>
-    bool BTreeNode<K, V>::remove(IOManagerT& io, const K key) {
+    bool BTreeNode<K, V>::set_entry_pos(IOManagerT& io, const K key, const int64_t entry_pos) {
+        auto [curr, entry, idx] = find_leaf_node_with_key(io, key);
+        if (entry.key != key)
+            return false;
+
+        curr.key_pos[idx] = entry_pos;
+        io.write_node(curr, curr.m_pos);
+        if (m_pos == curr.m_pos) // curr == this
+            *this = std::move(curr);
+        return true;
+    }
+
+    template <typename K, typename V>
+    bool BTreeNode<K, V>::remove(IOManagerT& io, const K key, std::map<K, int64_t>* taken_messages) {
         auto writeOnExit = [&io](const Node& node, const auto pos, bool success) -> bool {
             io.write_node(node, pos);
             return success;
         };
 
         auto idx = find_key_bin_search(io, key);
+        // the rebalancing below moves the keys and the children between the node and its children idx - 1 .. idx + 1
+        if (taken_messages)
+            take_messages(io, idx, *taken_messages);
+
         K curr_key = get_key(io, idx);
         if (idx < used_keys && curr_key == key) {
-            bool success = is_leaf ? remove_from_leaf(io, idx) : remove_from_non_leaf(io, idx);
+            bool success = is_leaf ? remove_from_leaf(io, idx) : remove_from_non_leaf(io, idx, taken_messages);
             return writeOnExit(*this, m_pos, success);
         }
 
@@ -220,20 +545,46 @@ namespace btree {
         // If the child where the key is supposed to exist has less that t keys, we fill that child
         // And wwe have to find the child again after "fill_node"
         auto child = get_child(io, idx);
-        if (child.used_keys < t)
+        if (child.used_keys < child.t)
             fill_node(io, idx);
 
         int32_t child_idx = (idx > used_keys) ? (idx - 1) : idx;
         child = get_child(io, child_idx);
 
         if (child.is_valid()) {
-            bool success = child.remove(io, key);
+            bool success = child.remove(io, key, taken_messages);
             return writeOnExit(child, child.m_pos, success);
         }
 
         return false;
     }
 
+    template <typename K, typename V>
+    void BTreeNode<K, V>::take_messages(IOManagerT& io, const int32_t idx, std::map<K, int64_t>& messages) {
+        if (is_leaf)
+            return;
+
+        // The node is visited before its children, so the first message of the KEY is the newest one
+        take_own_messages(io, messages);
+        for (auto i = std::max(idx - 1, 0); i <= std::min<int32_t>(idx + 1, used_keys); ++i) {
+            Node child = get_child(io, i);
+            if (child.is_leaf)
+                return;
+            child.take_own_messages(io, messages);
+        }
+    }
+
+    template <typename K, typename V>
+    void BTreeNode<K, V>::take_own_messages(IOManagerT& io, std::map<K, int64_t>& messages) {
+        if (msg_count == 0)
+            return;
+
+        for (auto i = 0; i < msg_count; ++i)
+            messages.try_emplace(msg_keys[i], msg_pos[i]);
+        msg_count = 0;
+        io.write_node(*this, m_pos);
+    }
+
     template <typename K, typename V>
     bool BTreeNode<K, V>::remove_from_leaf(IOManagerT& io, const int32_t idx) {
         // shift to the left by 1 all the keys after the pos
@@ -243,9 +594,9 @@ namespace btree {
     }
 
     template <typename K, typename V>
-    bool BTreeNode<K, V>::remove_from_non_leaf(IOManagerT& io, const int32_t idx) {
-        auto onExit = [&io](Node& curr, const K key) -> bool {
-            bool success = curr.remove(io, key);
+    bool BTreeNode<K, V>::remove_from_non_leaf(IOManagerT& io, const int32_t idx, std::map<K, int64_t>* taken_messages) {
+        auto onExit = [&io, taken_messages](Node& curr, const K key) -> bool {
+            bool success = curr.remove(io, key, taken_messages);
             io.write_node(curr, curr.m_pos);
             return success;
         };
@@ -253,7 +604,7 @@ namespace btree {
         // 1. If the child[pos] has >= T keys, find the PREVIOUS in the subtree rooted at child[pos].
         // 2. Replace keys[pos], values[pos] by the PREVIOUS[key|value].
         // 3. Recursively delete PREVIOUS in child[pos].
-        if (Node child = get_child(io, idx); child.used_keys >= t) {
+        if (Node child = get_child(io, idx); child.used_keys >= child.t) {
             auto curr_pos = get_prev_entry_pos(io, idx);
             key_pos[idx] = curr_pos;
             K key = io.read_key(curr_pos);
@@ -264,7 +615,7 @@ namespace btree {
         // 1. If child[pos + 1] has >= T keys, find the NEXT in the subtree rooted at child[pos + 1].
         // 2. Replace keys[pos], values[pos] by the NEXT[key|value].
         // 3. Recursively delete NEXT in child[pos + 1].
-        if (Node child = get_child(io, idx + 1); child.used_keys >= t) {
+        if (Node child = get_child(io, idx + 1); child.used_keys >= child.t) {
             auto curr_pos = get_next_entry_pos(io, idx);
             key_pos[idx] = curr_pos;
             K key = io.read_key(curr_pos);
@@ -307,16 +658,16 @@ namespace btree {
         Node next_child = get_child(io, idx + 1);
 
         // Set the key from CURR node to (t-1)th pos of child
-        child.key_pos[t - 1] = key_pos[idx];
+        child.key_pos[child.t - 1] = key_pos[idx];
 
         // Copy all keys from NEXT to CHILD
         for (auto i = 0; i < next_child.used_keys; ++i)
-            child.key_pos[i + t] = next_child.key_pos[i];
+            child.key_pos[i + child.t] = next_child.key_pos[i];
 
         // Copy all children from NEXT to CHILD
         if (!child.is_leaf) {
             for (auto i = 0; i <= next_child.used_keys; ++i)
-                child.child_pos[i + t] = next_child.child_pos[i];
+                child.child_pos[i + child.t] = next_child.child_pos[i];
         }
 
         // Increment CHILD's key count and write it
@@ -341,11 +692,11 @@ namespace btree {
         Node right_child = get_child(io, idx + 1);
 
         // If the left child has >= (T - 1) keys, borrow a key from it
-        if (idx != 0 && left_child.used_keys >= t) {
+        if (idx != 0 && left_child.used_keys >= left_child.t) {
             borrow_from_prev_node(io, idx);
 
             // If the right child has >= (T - 1) keys, borrow a key from it
-        } else if (idx != used_keys && right_child.used_keys >= t) {
+        } else if (idx != used_keys && right_child.used_keys >= right_child.t) {
             borrow_from_next_node(io, idx);
 
             // Merge child[idx] with its sibling
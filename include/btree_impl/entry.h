@@ -19,6 +19,8 @@ namespace btree::entry {
         const K key;
         const ValueType data;
         const int32_t size_in_bytes;
+        // milliseconds since the epoch, 0 means that the entry never expires
+        const int64_t expires_at = 0;
 
         template <typename U = V, enable_if_t<std::is_arithmetic_v<U>> = true>
         explicit Entry() :
@@ -60,15 +62,20 @@ namespace btree::entry {
             static_assert(sizeof(data_type) == sizeof(OriginalValueType));
         }
 
-        Entry(const K key, const ValueType value, const int size) :
+        Entry(const K key, const ValueType value, const int size, const int64_t expires_at = 0) :
                 key(key),
                 data(value),
-                size_in_bytes(size) {}
+                size_in_bytes(size),
+                expires_at(expires_at) {}
 
         bool is_valid() const {
             return (key != -1) && (size_in_bytes != 0);
         }
 
+        bool is_expired(const int64_t now) const {
+            return (expires_at != 0) && (expires_at <= now);
+        }
+
         std::optional<V> value() const {
             if (!size_in_bytes)
                 return std::nullopt;
@@ -76,14 +83,25 @@ namespace btree::entry {
             return cast_value();
         }
 
+        /** The value that doesn't refer to the file or to the buffer of the read */
+        std::optional<owned_value_t<V>> owned_value() const {
+            if constexpr(V_is_pointer) {
+                if (!size_in_bytes)
+                    return std::nullopt;
+                return owned_value_t<V>(reinterpret_cast<const char*>(data), size_in_bytes);
+            } else {
+                return value();
+            }
+        }
+
         template <typename U = V, enable_if_t<std::is_arithmetic_v<U>> = true>
         bool operator==(const Entry& e) const {
-            return data == e.data;
+            return data == e.data && expires_at == e.expires_at;
         }
 
         template <typename U = V, enable_if_t<is_string_v<U> || std::is_pointer_v<U>> = true>
         bool operator==(const Entry& e) const {
-            bool res = size_in_bytes == e.size_in_bytes;
+            bool res = size_in_bytes == e.size_in_bytes && expires_at == e.expires_at;
             for (int i = 0; i < size_in_bytes && res; ++i) {
                 res &= data[i] == e.data[i];
             }
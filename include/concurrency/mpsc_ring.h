@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+namespace btree::concurrency {
+    /**
+     * Bounded lock-free queue for many producers and one consumer (D. Vyukov's bounded MPMC queue):
+     *  - every cell has a sequence number that tells whose turn it is: the producer of the lap or the consumer
+     *  - producers claim the cells by CAS on the enqueue position, the consumer owns the dequeue position
+     *  - the producer spins (yields) while the queue is full
+     */
+    template <typename T>
+    class MpscRing {
+        struct Cell {
+            std::atomic<uint64_t> sequence;
+            T data;
+        };
+
+        std::vector<Cell> cells;
+        const uint64_t mask;
+        alignas(64) std::atomic<uint64_t> enqueue_pos;
+        alignas(64) uint64_t dequeue_pos;
+    public:
+        explicit MpscRing(const size_t capacity) : cells(capacity), mask(capacity - 1), enqueue_pos(0), dequeue_pos(0) {
+            if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+                throw std::logic_error("The capacity of the ring has to be a power of two");
+            for (size_t i = 0; i < capacity; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        /** Returns the ticket of the item: the number of items pushed before it plus one */
+        uint64_t push(T&& item) {
+            uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                auto& cell = cells[pos & mask];
+                auto sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.data = std::move(item);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return pos + 1;
+                    }
+                } else if (diff < 0) {
+                    // the ring is full: the consumer hasn't taken the item of the previous lap yet
+                    std::this_thread::yield();
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                } else {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /** Only the consumer thread can pop */
+        bool pop(T& item) {
+            auto& cell = cells[dequeue_pos & mask];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence != dequeue_pos + 1)
+                return false;
+
+            item = std::move(cell.data);
+            cell.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+            ++dequeue_pos;
+            return true;
+        }
+
+        /** Only the consumer thread can check whether the next item is pushed completely */
+        bool has_item() const {
+            return cells[dequeue_pos & mask].sequence.load(std::memory_order_acquire) == dequeue_pos + 1;
+        }
+
+        /** The ticket of the last claimed cell, the item can still be in progress */
+        uint64_t last_ticket() const {
+            return enqueue_pos.load(std::memory_order_acquire);
+        }
+    };
+}
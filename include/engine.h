@@ -0,0 +1,16 @@
+#pragma once
+
+namespace btree::engine {
+    /** Volume<K, V, BTreeEngine> keeps the key-value pairs in the B-tree inside the mapped file (see btree_impl) */
+    struct BTreeEngine {};
+
+    /** Volume<K, V, LSMEngine> keeps the key-value pairs in the log-structured merge tree (see lsm) */
+    struct LSMEngine {};
+
+    /** The engine of Volume<K, V>, Storage<K, V> and StorageMT<K, V>: the build with DEFAULT_LSM_ENGINE switches it to LSM */
+#ifdef DEFAULT_LSM_ENGINE
+    using DefaultEngine = LSMEngine;
+#else
+    using DefaultEngine = BTreeEngine;
+#endif
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "io/mapped_file.h"
+
+/**
+ * Hash index structures (a sidecar file next to the volume file):
+ *
+ * - Header (32 bytes):
+ *     - CAPACITY                 |=> takes 8 bytes -> the number of slots, always a power of two
+ *     - SIZE                     |=> takes 8 bytes -> the number of used slots
+ *     - VOLUME_END               |=> takes 8 bytes -> the volume file size the index was synced with on close
+ *     - STATE                    |=> takes 1 byte  -> STATE = 0 if the index was closed properly, 1 otherwise
+ *     - RESERVED                 |=> takes 7 bytes
+ *
+ * - Slot (8 + KEY_SIZE bytes):
+ *     - ENTRY_POS                |=> takes 8 bytes        -> entry pos in the volume file, INVALID_POS for empty slot
+ *     - KEY                      |=> takes KEY_SIZE bytes
+ *
+ * Open addressing with linear probing and backward-shift deletion (no tombstones).
+*/
+namespace btree::index {
+    template <typename K>
+    class HashIndex {
+        MappedFile<K, int64_t> file;
+        int64_t m_capacity;
+        int64_t m_size;
+
+        static constexpr int64_t CAPACITY_POS = 0;
+        static constexpr int64_t SIZE_POS = 8;
+        static constexpr int64_t VOLUME_END_POS = 16;
+        static constexpr int64_t STATE_POS = 24;
+        static constexpr int64_t HEADER_SIZE = 32;
+        static constexpr int64_t SLOT_SIZE = sizeof(int64_t) + sizeof(K);
+
+        static constexpr int64_t INITIAL_CAPACITY = 1024;
+        static constexpr uint8_t STATE_CLOSED = 0;
+        static constexpr uint8_t STATE_OPENED = 1;
+    public:
+        static constexpr int64_t INVALID_POS = -1;
+
+        explicit HashIndex(const std::string& path);
+
+        /** The index can be trusted only if it was closed properly together with the volume of VOLUME_END size */
+        bool is_synced_with(const int64_t volume_end);
+
+        /** Marks the index as opened, so it's rebuilt on the next open if the process doesn't call close(...) */
+        void open();
+        void close(const int64_t volume_end);
+
+        int64_t find(const K key);
+        void insert_or_assign(const K key, const int64_t entry_pos);
+        bool erase(const K key);
+        void clear();
+
+        int64_t size() const;
+    private:
+        uint64_t home_slot(const K key) const;
+        int64_t slot_pos(const uint64_t slot) const;
+
+        int64_t read_slot_entry_pos(const uint64_t slot);
+        K read_slot_key(const uint64_t slot);
+        void write_slot(const uint64_t slot, const K key, const int64_t entry_pos);
+
+        void write_empty_slots(const int64_t capacity);
+        void write_size();
+        void grow();
+    };
+}
+
+#include "hash_index_impl.h"
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+
+namespace btree::index {
+    template <typename K>
+    HashIndex<K>::HashIndex(const std::string& path) : file(path, 0), m_capacity(0), m_size(0) {
+        // the probes of the slots are random, the readahead of the neighbour pages is wasted
+        file.advise(io::Advice::RANDOM);
+        if (file.is_empty()) {
+            write_empty_slots(INITIAL_CAPACITY);
+            return;
+        }
+
+        file.set_pos(CAPACITY_POS);
+        m_capacity = file.read_int64();
+        m_size = file.read_int64();
+    }
+
+    template <typename K>
+    bool HashIndex<K>::is_synced_with(const int64_t volume_end) {
+        file.set_pos(VOLUME_END_POS);
+        auto synced_volume_end = file.read_int64();
+        auto state = file.read_byte();
+        return (state == STATE_CLOSED) && (synced_volume_end == volume_end);
+    }
+
+    template <typename K>
+    void HashIndex<K>::open() {
+        file.set_pos(STATE_POS);
+        file.write_next_primitive(STATE_OPENED);
+    }
+
+    template <typename K>
+    void HashIndex<K>::close(const int64_t volume_end) {
+        file.set_pos(VOLUME_END_POS);
+        file.write_next_primitive(volume_end);
+        file.write_next_primitive(STATE_CLOSED);
+    }
+
+    template <typename K>
+    int64_t HashIndex<K>::find(const K key) {
+        const uint64_t mask = m_capacity - 1;
+        for (uint64_t slot = home_slot(key); ; slot = (slot + 1) & mask) {
+            auto entry_pos = read_slot_entry_pos(slot);
+            if (entry_pos == INVALID_POS || read_slot_key(slot) == key)
+                return entry_pos;
+        }
+    }
+
+    template <typename K>
+    void HashIndex<K>::insert_or_assign(const K key, const int64_t entry_pos) {
+        // keep the load factor below 0.7 to have short probe sequences
+        if ((m_size + 1) * 10 > m_capacity * 7)
+            grow();
+
+        const uint64_t mask = m_capacity - 1;
+        for (uint64_t slot = home_slot(key); ; slot = (slot + 1) & mask) {
+            auto curr_pos = read_slot_entry_pos(slot);
+            if (curr_pos == INVALID_POS) {
+                write_slot(slot, key, entry_pos);
+                ++m_size;
+                write_size();
+                return;
+            }
+            if (read_slot_key(slot) == key) {
+                if (curr_pos != entry_pos)
+                    write_slot(slot, key, entry_pos);
+                return;
+            }
+        }
+    }
+
+    template <typename K>
+    bool HashIndex<K>::erase(const K key) {
+        const uint64_t mask = m_capacity - 1;
+        uint64_t hole = home_slot(key);
+        for (; ; hole = (hole + 1) & mask) {
+            if (read_slot_entry_pos(hole) == INVALID_POS)
+                return false;
+            if (read_slot_key(hole) == key)
+                break;
+        }
+
+        // Backward-shift: move the following entries of the cluster to the hole if their home slot allows it
+        for (uint64_t next = (hole + 1) & mask; ; next = (next + 1) & mask) {
+            auto entry_pos = read_slot_entry_pos(next);
+            if (entry_pos == INVALID_POS)
+                break;
+
+            K next_key = read_slot_key(next);
+            uint64_t home = home_slot(next_key);
+            bool home_is_cyclically_in_hole_next = (hole <= next) ?
+                    (hole < home && home <= next) :
+                    (hole < home || home <= next);
+            if (!home_is_cyclically_in_hole_next) {
+                write_slot(hole, next_key, entry_pos);
+                hole = next;
+            }
+        }
+        write_slot(hole, 0, INVALID_POS);
+        --m_size;
+        write_size();
+        return true;
+    }
+
+    template <typename K>
+    void HashIndex<K>::clear() {
+        write_empty_slots(INITIAL_CAPACITY);
+        file.set_pos(slot_pos(INITIAL_CAPACITY));
+        file.shrink_to_fit();
+    }
+
+    template <typename K>
+    int64_t HashIndex<K>::size() const {
+        return m_size;
+    }
+
+    template <typename K>
+    uint64_t HashIndex<K>::home_slot(const K key) const {
+        // splitmix64 finalizer: sequential keys are spread over the whole table
+        auto h = static_cast<uint64_t>(key);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h = h ^ (h >> 31);
+        return h & (m_capacity - 1);
+    }
+
+    template <typename K>
+    int64_t HashIndex<K>::slot_pos(const uint64_t slot) const {
+        return HEADER_SIZE + static_cast<int64_t>(slot) * SLOT_SIZE;
+    }
+
+    template <typename K>
+    int64_t HashIndex<K>::read_slot_entry_pos(const uint64_t slot) {
+        file.set_pos(slot_pos(slot));
+        return file.read_int64();
+    }
+
+    template <typename K>
+    K HashIndex<K>::read_slot_key(const uint64_t slot) {
+        file.set_pos(slot_pos(slot) + sizeof(int64_t));
+        return file.template read_next_primitive<K>();
+    }
+
+    template <typename K>
+    void HashIndex<K>::write_slot(const uint64_t slot, const K key, const int64_t entry_pos) {
+        file.set_pos(slot_pos(slot));
+        file.write_next_primitive(entry_pos);
+        file.write_next_primitive(key);
+    }
+
+    template <typename K>
+    void HashIndex<K>::write_empty_slots(const int64_t capacity) {
+        m_capacity = capacity;
+        m_size = 0;
+
+        file.set_pos(CAPACITY_POS);
+        file.write_next_primitive(m_capacity);
+        file.write_next_primitive(m_size);
+        file.write_next_primitive(INVALID_POS);
+        file.write_next_primitive(STATE_OPENED);
+
+        // the last slot goes first to resize the file only once
+        for (auto slot = capacity - 1; slot >= 0; --slot)
+            write_slot(slot, 0, INVALID_POS);
+    }
+
+    template <typename K>
+    void HashIndex<K>::write_size() {
+        file.set_pos(SIZE_POS);
+        file.write_next_primitive(m_size);
+    }
+
+    template <typename K>
+    void HashIndex<K>::grow() {
+        std::vector<std::pair<K, int64_t>> used_slots;
+        used_slots.reserve(m_size);
+        for (int64_t slot = 0; slot < m_capacity; ++slot) {
+            auto entry_pos = read_slot_entry_pos(slot);
+            if (entry_pos != INVALID_POS)
+                used_slots.emplace_back(read_slot_key(slot), entry_pos);
+        }
+
+        write_empty_slots(m_capacity * 2);
+        for (const auto& [key, entry_pos]: used_slots)
+            insert_or_assign(key, entry_pos);
+    }
+}
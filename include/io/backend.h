@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace btree::io {
+    /** The way the volume file is accessed, the file format doesn't depend on it */
+    enum class Backend : uint8_t {
+        /** The file is mapped to memory (MappedFile) */
+        MMAP,
+        /** pread|pwrite through the user-space page cache (PositionalFile) */
+        PREAD,
+        /**
+         * PREAD with the kernel page cache bypassed (O_DIRECT, F_NOCACHE on macOS): the nodes start at the block
+         * boundaries, so the user-space page cache is the only cache of the volume
+         */
+        DIRECT
+    };
+
+    /**
+     * The expected access to the volume file (madvise of the mapping, fadvise of the PREAD file):
+     * the kernel readahead is tuned to it, the file content doesn't depend on it
+     */
+    enum class Advice : uint8_t {
+        NORMAL,
+        /** Point lookups: the readahead is disabled, the fault reads only the page it needs */
+        RANDOM,
+        /** Scans: the aggressive readahead, the pages behind the reader can be dropped first */
+        SEQUENTIAL,
+        /** The whole file is read ahead in the background */
+        WILLNEED
+    };
+
+    /** The unit of the direct I/O: the pages of the page cache, the alignment of the nodes and values */
+    constexpr int64_t block_size = 4096;
+
+    /** The size of the transparent huge page on x86-64 and arm64 with 4 KB pages */
+    constexpr int64_t huge_page_size = 2 * 1024 * 1024;
+
+    /** The settings of the volume file, see VolumeOptions */
+    struct FileOptions {
+        Backend backend = Backend::MMAP;
+        size_t page_cache_size_in_bytes = 0;
+        bool use_io_uring = true;
+        Advice advice = Advice::NORMAL;
+    };
+}
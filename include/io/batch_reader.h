@@ -0,0 +1,113 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+
+#include "uring.h"
+#include "file_handle.h"
+#include "utils/boost_include.h"
+
+namespace btree::io {
+    /**
+     * Library-owned pool for the batched reads without io_uring. It's separate from async::Executor:
+     * the async operation waits for its reads, so they can't be queued to the pool that runs it.
+     */
+    class ReadPool final {
+        basio::thread_pool pool;
+
+        ReadPool() : pool(std::min(4u, std::max(1u, std::thread::hardware_concurrency()))) {}
+    public:
+        ReadPool(const ReadPool&) = delete;
+        ReadPool& operator=(const ReadPool&) = delete;
+
+        static ReadPool& instance() {
+            // never destroyed: the static storages can read after the exit from main
+            static auto* read_pool = new ReadPool();
+            return *read_pool;
+        }
+
+        /** Runs the reads in parallel and waits for them, the first failure is rethrown */
+        void read(const FileHandle& file, const std::vector<ReadRequest>& requests) {
+            std::mutex mutex;
+            std::condition_variable done;
+            size_t pending = requests.size();
+            std::exception_ptr error;
+            for (const auto& request: requests) {
+                basio::post(pool, [&file, &request, &mutex, &done, &pending, &error] {
+                    std::exception_ptr curr_error;
+                    try {
+                        file.read(request.pos, request.dst, request.size);
+                    } catch (...) {
+                        curr_error = std::current_exception();
+                    }
+                    std::scoped_lock lock(mutex);
+                    if (curr_error && !error)
+                        error = curr_error;
+                    if (--pending == 0)
+                        done.notify_one();
+                });
+            }
+            std::unique_lock lock(mutex);
+            done.wait(lock, [&pending] { return pending == 0; });
+            if (error)
+                std::rethrow_exception(error);
+        }
+    };
+
+    /**
+     * Reads the batch of file ranges at once: the requests are submitted to io_uring together,
+     * or run by ReadPool if io_uring is disabled or the kernel doesn't support it
+     */
+    class BatchReader final {
+        static constexpr uint32_t queue_depth = 64;
+
+        const bool use_io_uring;
+        std::unique_ptr<Uring> uring;
+    public:
+        explicit BatchReader(const bool use_io_uring) : use_io_uring(use_io_uring) {}
+
+        /** The ring is set up by the first batch */
+        bool uses_io_uring() {
+            if (use_io_uring && !uring)
+                uring = std::make_unique<Uring>(queue_depth);
+            return uring && uring->is_ready();
+        }
+
+        void read(const FileHandle& file, const std::vector<ReadRequest>& requests) {
+            if (requests.empty())
+                return;
+            if (requests.size() == 1) {
+                file.read(requests[0].pos, requests[0].dst, requests[0].size);
+                return;
+            }
+
+            if (uses_io_uring()) {
+                auto results = uring->read(file.native(), requests);
+                for (size_t i = 0; i < requests.size(); ++i) {
+                    const auto& request = requests[i];
+                    if (results[i] < 0 && !uring->is_ready()) {
+                        // the ring failed, the rest of the batch is read without it
+                        file.read(request.pos, request.dst, request.size);
+                        continue;
+                    }
+                    utils::validate(results[i] >= 0, error_msg::io_error_msg, file.path);
+                    // the short read at the end of the file or an interrupted one is repeated from the aligned start
+                    if (results[i] < request.size)
+                        file.read(request.pos, request.dst, request.size);
+                }
+                return;
+            }
+#if defined(_WIN32)
+            // the reads of the handle move the file pointer, so they aren't parallel
+            for (const auto& request: requests)
+                file.read(request.pos, request.dst, request.size);
+#else
+            ReadPool::instance().read(file, requests);
+#endif
+        }
+    };
+}
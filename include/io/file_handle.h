@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string>
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include "backend.h"
+#include "utils/utils.h"
+#include "utils/error.h"
+
+namespace btree::io {
+    /**
+     * Positional reads and writes of the file without the mapping: pread|pwrite on POSIX,
+     * seek + read|write on Windows (the handle isn't shared between threads).
+     * The failed operation throws, the read past the end of the file returns zeros.
+     *
+     * The direct handle bypasses the kernel page cache (O_DIRECT, F_NOCACHE on macOS): the positions, sizes and
+     * buffers of its reads and writes have to be aligned to block_size. The file system without the direct I/O
+     * (tmpfs, Windows without the unbuffered handle) gets the buffered handle, see is_direct().
+     */
+    class FileHandle final {
+        int fd;
+        bool direct = false;
+    public:
+        const std::string path;
+
+        explicit FileHandle(const std::string& path, const bool use_direct_io = false) : path(path) {
+#if defined(_WIN32)
+            fd = _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+#if defined(O_DIRECT)
+            if (use_direct_io) {
+                fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+                direct = fd >= 0;
+                if (fd < 0 && errno == EINVAL)
+                    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            } else {
+                fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            }
+#else
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+#if defined(F_NOCACHE)
+            if (fd >= 0 && use_direct_io)
+                direct = ::fcntl(fd, F_NOCACHE, 1) == 0;
+#endif
+#endif
+#endif
+            utils::validate(fd >= 0, error_msg::io_error_msg, path);
+        }
+
+        FileHandle(const FileHandle&) = delete;
+        FileHandle& operator=(const FileHandle&) = delete;
+
+        ~FileHandle() {
+#if defined(_WIN32)
+            _close(fd);
+#else
+            ::close(fd);
+#endif
+        }
+
+        int native() const {
+            return fd;
+        }
+
+        bool is_direct() const {
+            return direct;
+        }
+
+        int64_t size() const {
+#if defined(_WIN32)
+            struct _stat64 st{};
+            utils::validate(_fstat64(fd, &st) == 0, error_msg::io_error_msg, path);
+#else
+            struct stat st{};
+            utils::validate(::fstat(fd, &st) == 0, error_msg::io_error_msg, path);
+#endif
+            return static_cast<int64_t>(st.st_size);
+        }
+
+        void read(int64_t pos, uint8_t* dst, int64_t n) const {
+            while (n > 0) {
+                auto res = read_some(pos, dst, n);
+                utils::validate(res >= 0, error_msg::io_error_msg, path);
+                // the direct read isn't continued at the unaligned end of the file
+                if (res == 0 || (direct && res < n)) {
+                    std::fill(dst + res, dst + n, 0);
+                    return;
+                }
+                pos += res;
+                dst += res;
+                n -= res;
+            }
+        }
+
+        void write(int64_t pos, const uint8_t* src, int64_t n) const {
+            while (n > 0) {
+                auto res = write_some(pos, src, n);
+                utils::validate(res > 0, error_msg::io_error_msg, path);
+                pos += res;
+                src += res;
+                n -= res;
+            }
+        }
+
+        void truncate(const int64_t size) const {
+#if defined(_WIN32)
+            utils::validate(_chsize_s(fd, size) == 0, error_msg::io_error_msg, path);
+#else
+            utils::validate(::ftruncate(fd, size) == 0, error_msg::io_error_msg, path);
+#endif
+        }
+
+        /** The readahead of the kernel page cache, the direct handle doesn't use it */
+        void advise(const Advice advice) const {
+#if defined(POSIX_FADV_NORMAL)
+            if (direct)
+                return;
+            int unix_advice = POSIX_FADV_NORMAL;
+            switch (advice) {
+                case Advice::NORMAL: unix_advice = POSIX_FADV_NORMAL; break;
+                case Advice::RANDOM: unix_advice = POSIX_FADV_RANDOM; break;
+                case Advice::SEQUENTIAL: unix_advice = POSIX_FADV_SEQUENTIAL; break;
+                case Advice::WILLNEED: unix_advice = POSIX_FADV_WILLNEED; break;
+            }
+            ::posix_fadvise(fd, 0, 0, unix_advice);
+#else
+            (void)advice;
+#endif
+        }
+
+    private:
+        int64_t read_some(const int64_t pos, uint8_t* dst, const int64_t n) const {
+#if defined(_WIN32)
+            if (_lseeki64(fd, pos, SEEK_SET) < 0)
+                return -1;
+            return _read(fd, dst, static_cast<unsigned int>(n));
+#else
+            return ::pread(fd, dst, static_cast<size_t>(n), pos);
+#endif
+        }
+
+        int64_t write_some(const int64_t pos, const uint8_t* src, const int64_t n) const {
+#if defined(_WIN32)
+            if (_lseeki64(fd, pos, SEEK_SET) < 0)
+                return -1;
+            return _write(fd, src, static_cast<unsigned int>(n));
+#else
+            return ::pwrite(fd, src, static_cast<size_t>(n), pos);
+#endif
+        }
+    };
+}
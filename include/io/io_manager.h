@@ -1,12 +1,16 @@
 #pragma once
 
-#include "mapped_file.h"
+#include <unordered_map>
+
+#include "volume_file.h"
+#include "value_log.h"
+#include "value_codec.h"
 #include "utils/forward_decl.h"
 
 /**
  * Storage structures:
  *
- * - Header (6 bytes):
+ * - Header (13 bytes, or 16 bytes with EXTENDED_HEADER_BIT):
  *     - T                        |=> takes 2 bytes -> tree degree
  *     - KEY_SIZE                 |=> takes 1 byte
  *     - VALUE_TYPE               |=> takes 1 byte ->  VALUE_TYPE = 0 for integer primitives: int32_t, int64_t
@@ -14,25 +18,82 @@
  *                                                     VALUE_TYPE = 2 for floating-point primitives: float, double
  *                                                     VALUE_TYPE = 3 for container of values: (w)string
  *                                                     VALUE_TYPE = 4 for blob
+ *                                                     with EXTENDED_HEADER_BIT if BUFFER_SIZE or FLAGS isn't 0
  *
  *     - ELEMENT_SIZE             |=> takes 1 byte  -> ELEMENT_SIZE = sizeof(VALUE_TYPE) for primitives
  *                                                     ELEMENT_SIZE = sizeof(VALUE_SUBTYPE) for containers or blob
+ *     ----------–----- only with EXTENDED_HEADER_BIT:
+ *     - BUFFER_SIZE              |=> takes 2 bytes -> max number of messages in the internal node (0 for the plain B-tree)
+ *     - FLAGS                    |=> takes 1 byte  -> bit 0 is set if entries have EXPIRES_AT (the volume with TTL)
+ *                                                     bit 1 is set if the internal nodes are in the node file
+ *                                                     bit 2 is set if all the nodes are in the node file
+ *                                                     bit 3 is set if the big values are in the value log
+ *                                                     bit 4 is set if the leaves keep the copies of the entries
+ *                                                     bit 5 is set if the nodes keep the compact positions
+ *                                                     bit 6 is set if the leaves keep the compressed keys of the copies
+ *                                                     bit 7 is set if the (w)string|blob values have CODEC
+ *     ----------–-----
  *     - ROOT POS                 |=> takes 8 bytes -> pos in file
+ *   The volume without the buffers and the flags keeps the plain header, so the files of the plain B-tree
+ *   are read and written by the older versions as they are.
+ *
+ * The volume with io::Backend::DIRECT has the aligned layout of the same format: the nodes start at the block
+ * boundaries (io::block_size), the entry doesn't cross the boundary if it fits in the block, the bigger one starts
+ * at the boundary. The gaps are never read, so the file can be reopened with any backend.
  *
  * - Node (N bytes):
  *     - FLAG                     |=> takes 1 byte                 -> for "is_deleted" or "is_leaf"
  *     - USED_KEYS                |=> takes 2 bytes                -> for the number of "active" keys in the node
- *     - KEY_POS                  |=> takes (2 * t - 1) * KEY_SIZE -> for key positions in file
- *     - CHILD_POS                |=> takes (2 * t) * KEY_SIZE     -> for key positions in file
+ *     - KEY_POS                  |=> takes (2 * t - 1) * POS_SIZE -> for key positions in file, t is the order of the node
+ *     - CHILD_POS                |=> takes (2 * t) * CHILD_POS_SIZE -> for child positions in file
+ *     ----------–----- only for the internal node if BUFFER_SIZE > 0:
+ *        - MSG_COUNT             |=> takes 2 bytes                -> for the number of pending messages
+ *        - MSG_KEYS              |=> takes BUFFER_SIZE * KEY_SIZE -> for the sorted keys of messages
+ *        - MSG_POS               |=> takes BUFFER_SIZE * POS_SIZE -> for entry positions of messages
+ *     ----------–-----
+ *     POS_SIZE = CHILD_POS_SIZE = 8 bytes for the byte offsets. If FLAGS has bit 5 (the compact positions), all the
+ *     nodes are in the node file in the slots of the biggest node size, CHILD_POS_SIZE = 4 bytes for the slot index
+ *     (up to 2^32 - 1 nodes, e.g. 16 TB of 4 KB nodes) and POS_SIZE = 6 bytes for the entry offset in the volume file
+ *     (the 4-byte index of the 64 KB page and the offset in the page, up to 2^48 bytes = 256 TB); all ones is
+ *     INVALID_POS. The allocation beyond the limits throws before the node or entry is written.
+ *     ----------–----- only for the leaf if FLAGS has bit 4 (the arithmetic VALUE_TYPE):
+ *        - INLINE_ENTRIES        |=> takes (2 * t - 1) * (KEY_SIZE + [8] + ELEMENT_SIZE) bytes -> the copies of KEY,
+ *                                    EXPIRES_AT (if FLAGS has bit 0) and VALUE of the entries at KEY_POS, so the lookup
+ *                                    ends in the leaf; the copies are rewritten with the leaf and the in-place updates
+ *     or, if FLAGS has bit 6 too, the copies without KEY:
+ *        - KEY_BASE              |=> takes KEY_SIZE bytes         -> the smallest key of the leaf
+ *        - KEY_WIDTH             |=> takes 1 byte                 -> 1, 2 or 4 up to KEY_SIZE / 2, 0 if the keys don't fit
+ *        - KEY_DELTAS            |=> takes (2 * t - 1) * KEY_SIZE / 2 bytes -> KEY[i] - KEY_BASE of KEY_WIDTH bytes each,
+ *                                    packed, so the search in the leaf compares the deltas; the leaf of the keys
+ *                                    that don't fit is searched and read through the entries
+ *        - INLINE_ENTRIES        |=> takes (2 * t - 1) * ([8] + ELEMENT_SIZE) bytes -> EXPIRES_AT and VALUE
+ *     ----------–-----
+ *   The page is the plain node of order T: the leaves and the internal nodes take the biggest orders whose nodes
+ *   (without the buffer) fit the page, so the plain B-tree has order T everywhere and the leaves with the copies
+ *   or the nodes with the compact positions have their own orders (see IOManager::order).
+ *
+ * - Node file "<volume path>.nodes" (only if FLAGS has bit 1 or 2), the internal nodes or all the nodes are allocated
+ *   there, the volume file with bit 2 is the heap of the entries:
+ *     - MAGIC                    |=> takes 8 bytes
+ *     - NODES                    |=> the nodes of the same layout, their positions have NODE_FILE_BIT set
  *
  * - Entry (M bytes):
  *     - KEY                      |=> takes KEY_SIZE bytes (4 bytes is enough for 10^8 different keys)
+ *     - EXPIRES_AT               |=> takes 8 bytes, only if FLAGS has bit 0 -> milliseconds since the epoch, 0 for never
  *     ----------–-----
  *        - VALUE                 |=> takes ELEMENT_SIZE bytes for primitive VALUE_TYPE
  *     or
  *        - NUMBER_OF_ELEMENTS    |=> takes 4 bytes
  *        - VALUES                |=> takes (ELEMENT_SIZE * NUMBER_OF_ELEMENTS) bytes
+ *     or, only if FLAGS has bit 7:
+ *        - NUMBER_OF_BYTES       |=> takes 4 bytes
+ *        - ENCODED VALUE         |=> takes NUMBER_OF_BYTES bytes -> CODEC and the raw or compressed VALUES (see io::Codec)
+ *     or, only if FLAGS has bit 3 for the value of the value log threshold size or bigger:
+ *        - NUMBER_OF_ELEMENTS    |=> takes 4 bytes -> negated, so the entry is told from the inline one
+ *        - VALUE_POS             |=> takes 8 bytes -> the record position in the value log (see ValueLog)
  *     ----------–-----
+ *   The new value of the KEY is written over the entry if it takes no more bytes (see overwrite_or_write_entry),
+ *   the bigger one goes to the new entry at the end of the file.
 */
 namespace btree {
     template <typename K, typename V>
@@ -41,24 +102,118 @@ namespace btree {
         using EntryT = typename BTree<K, V>::EntryT;
 
         const int16_t t = 0;
-        MappedFile<K,V> file;
+        const int16_t buffer_size = 0;
+        const uint8_t flags = 0;
+        const int64_t alignment = 0;
+        // the orders of the internal nodes and the leaves, see page_size_in_bytes()
+        const int16_t internal_t = 0;
+        const int16_t leaf_t = 0;
+        // the slot of the node in the node file of the volume with COMPACT_POS_FLAG
+        const int64_t node_stride = 0;
+        VolumeFile<K,V> file;
+        std::unique_ptr<MappedFile<K, V>> node_file;
+        std::unique_ptr<ValueLog<K, V>> value_log;
+        const int32_t value_log_threshold = 0;
+        const int32_t compression_threshold = 0;
+        // the encoded value of the entry being written (COMPRESSION_FLAG)
+        std::vector<uint8_t> value_buffer;
+        // the decompressed values of the read entries by the entry position, the value lives until its entry
+        // is overwritten like the value of the mapped file, so the blob pointer of get(...) stays valid
+        std::unordered_map<int64_t, std::vector<uint8_t>> decoded_values;
+        // the copies of the entries written last (INLINE_LEAF_FLAG) in the slots of their positions, so the leaf
+        // written after its new entries doesn't read them back
+        std::vector<typename BTreeNode<K, V>::InlineEntry> written_entries;
+        static constexpr size_t written_entry_count = 1024;
 
         static constexpr uint8_t ROOT_POS_IN_HEADER = sizeof(t) + 3;
+        static constexpr uint8_t EXTENDED_HEADER_BIT = 128;
     public:
+        static constexpr uint8_t EXPIRY_FLAG = 1;
+        static constexpr uint8_t NODE_FILE_FLAG = 2;
+        static constexpr uint8_t INDEX_FILE_FLAG = 4;
+        static constexpr uint8_t VALUE_LOG_FLAG = 8;
+        static constexpr uint8_t INLINE_LEAF_FLAG = 16;
+        static constexpr uint8_t COMPACT_POS_FLAG = 32;
+        static constexpr uint8_t KEY_FRAME_FLAG = 64;
+        /** The volume with COMPACT_POS_FLAG has up to 2^32 - 1 nodes and the entries below 2^48 bytes (256 TB) */
+        static constexpr int64_t COMPACT_NODE_LIMIT = (int64_t(1) << 32) - 1;
+        static constexpr int64_t COMPACT_ENTRY_POS_LIMIT = (int64_t(1) << 48) - 1;
+        static constexpr uint8_t COMPRESSION_FLAG = 128;
+        /** The node position in the node file is tagged with the bit, the tree doesn't distinguish the files */
+        static constexpr int64_t NODE_FILE_BIT = int64_t(1) << 62;
+
+        /** The size of the plain header */
         static constexpr int64_t INITIAL_ROOT_POS_IN_HEADER = ROOT_POS_IN_HEADER + sizeof(int64_t);
         static constexpr int64_t INVALID_POS = -1;
 
-        IOManager(const std::string& path, const int16_t user_t);
+        IOManager(const std::string& path, const int16_t user_t, const int16_t user_buffer_size = 0, const uint8_t user_flags = 0,
+                  const io::FileOptions& file_options = io::FileOptions(), const int32_t user_value_log_threshold = 0,
+                  const int64_t value_log_segment_size = 0, const int32_t user_compression_threshold = 0);
 
         bool is_ready() const;
+        /** The order of the leaves or the internal nodes, the nodes of the layout of the volume fit the page */
+        int16_t order(const bool is_leaf) const;
+
+        /** The position of the new node at the end of the file, the internal one goes to the node file if any */
+        int64_t allocate_node(const bool is_leaf);
+        /** The position of the new entry at the end of the volume file */
+        int64_t allocate_entry(const EntryT& e);
 
         int64_t write_node(const Node& node, const int64_t pos);
         void write_entry(const EntryT& e, const int64_t pos);
+        /**
+         * Writes E over the entry of the same KEY at POS if E fits in its place: the fixed-size values always fit,
+         * the (w)string|blob value fits if it takes no more bytes than the old one. Otherwise E is written to the new
+         * entry at the end of the volume file. Returns the position of the written entry
+         */
+        int64_t overwrite_or_write_entry(const EntryT& e, const int64_t pos);
 
         Node read_node(const int64_t pos);
         EntryT read_entry(const int64_t pos);
         K read_key(const int64_t pos);
 
+        /** The leaves keep the copies of the entries (INLINE_LEAF_FLAG) */
+        bool has_inline_entries() const;
+        /** The leaves keep the keys of the copies as the deltas of the smallest one (KEY_FRAME_FLAG) */
+        bool has_key_frames() const;
+        /** Rewrites the copy of the entry at KEY_POS[IDX] of the leaf after the entry is overwritten in place */
+        void write_inline_entry(const Node& node, const int32_t idx, const EntryT& e);
+
+        /** The value log of the volume with VALUE_LOG_FLAG, nullptr otherwise */
+        ValueLog<K, V>* get_value_log();
+        /** The value log position of the entry value, INVALID_POS if the value is in the entry */
+        int64_t read_value_pos(const int64_t entry_pos);
+        /** The value of the entry is moved in the value log by the garbage collection */
+        void write_value_pos(const int64_t entry_pos, const int64_t value_pos);
+
+        /**
+         * Random access to the node fields for the batched lookup: it prefetches the fields it needs next
+         * instead of reading the whole node
+         */
+        void prefetch(const int64_t pos);
+        /** Prefetches the whole node, the node of the internal level may have the buffer */
+        void prefetch_node(const int64_t node_pos);
+        /** Issues the prefetches at once: the batch of reads for the explicit I/O backend */
+        void submit_prefetches();
+        /** The node at NODE_POS is internal, the page cache of the explicit I/O backend keeps it longer */
+        void keep_internal_node(const int64_t node_pos);
+        /** The advice of the whole volume file, see io::Advice */
+        void advise(const io::Advice advice);
+        /** The one-time advice of the range, e.g. WILLNEED of the whole file before the full traversal */
+        void advise(const int64_t pos, const int64_t size, const io::Advice advice) const;
+        template <typename T>
+        T read_at(const int64_t pos);
+        /** Reads the entry position field of the node: KEY_POS or MSG_POS */
+        int64_t read_entry_pos_at(const int64_t pos);
+        /** Reads CHILD_POS of the node */
+        int64_t read_child_pos_at(const int64_t pos);
+        int64_t used_keys_pos(const int64_t node_pos) const;
+        int64_t key_pos_pos(const int64_t node_pos, const int32_t idx) const;
+        int64_t child_pos_pos(const int64_t node_pos, const int32_t idx) const;
+        int64_t msg_count_pos(const int64_t node_pos) const;
+        int64_t msg_key_pos(const int64_t node_pos, const int32_t idx) const;
+        int64_t msg_pos_pos(const int64_t node_pos, const int32_t idx) const;
+
         int64_t read_header();
         int64_t write_header();
 
@@ -66,6 +221,74 @@ namespace btree {
         void write_new_pos_for_root_node(const int64_t posRoot);
 
         int64_t get_file_pos_end();
+
+    private:
+        static constexpr int64_t NODE_FILE_MAGIC = 0x5345444f4e455254; // "TRENODES"
+        static constexpr int64_t NODE_FILE_HEADER_SIZE = sizeof(NODE_FILE_MAGIC);
+        static constexpr int64_t COMPACT_ENTRY_POS_SIZE = 6;
+
+        void open_node_file();
+        /** The volume with the index file or the compact positions keeps the leaves in the node file too */
+        bool has_all_nodes_in_node_file() const;
+        /** The header has BUFFER_SIZE and FLAGS only if any of them isn't 0 */
+        bool has_extended_header() const;
+        /** The pos of ROOT POS in the header of the volume */
+        int64_t root_pos_in_header() const;
+        int64_t allocate_entry(const EntryT& e, const int64_t end);
+        void write_entry(const EntryT& e, const int64_t pos, const std::pair<typename EntryT::ValueType, int32_t>& value);
+        /** Writes the encoded VALUE of E over the entry at POS, returns false if it doesn't fit */
+        bool overwrite_entry(const EntryT& e, const int64_t pos, const std::pair<typename EntryT::ValueType, int32_t>& value);
+        /** The value of E as it's written to the entry: encoded with CODEC if FLAGS has COMPRESSION_FLAG */
+        std::pair<typename EntryT::ValueType, int32_t> encode_value(const EntryT& e);
+
+        /** Calls fn(file, pos in the file) for the volume file or the node file by NODE_FILE_BIT of POS */
+        template <typename Fn>
+        auto with_file(const int64_t pos, Fn&& fn);
+
+        /**
+         * The plain node of order T: the internal nodes and the leaves take the biggest orders that fit the page,
+         * so the volume with the smaller positions or the copies of the entries has other orders
+         */
+        int64_t page_size_in_bytes() const;
+        int16_t derive_order(const bool is_leaf) const;
+        /** The node of the internal level may have the buffer */
+        int64_t internal_node_size_in_bytes() const;
+        int64_t leaf_size_in_bytes() const;
+        /** The node of ORDER without the buffer and the inline entries */
+        int64_t node_size_in_bytes(const int32_t order) const;
+        /** The size of KEY_POS and MSG_POS */
+        int64_t entry_pos_size() const;
+        /** The size of CHILD_POS */
+        int64_t child_pos_size() const;
+        /** IS_CHILD for CHILD_POS, the entry positions otherwise */
+        template <typename File>
+        void write_pos_vector(File& file, const std::vector<int64_t>& vec, const bool is_child) const;
+        template <typename File>
+        void read_pos_vector(File& file, std::vector<int64_t>& vec, const bool is_child) const;
+        /** Throws if the node or entry at POS can't be kept as the compact position, returns POS otherwise */
+        int64_t check_compact_pos(const int64_t pos) const;
+        /** The index of the node slot in the node file */
+        int64_t to_node_index(const int64_t pos) const;
+        uint32_t to_compact_child_pos(const int64_t pos) const;
+        int64_t from_compact_child_pos(const uint32_t pos) const;
+        uint64_t to_compact_entry_pos(const int64_t pos) const;
+        int64_t from_compact_entry_pos(const uint64_t pos) const;
+        bool is_in_value_log(const EntryT& e) const;
+        /** The bytes of NUMBER_OF_ELEMENTS and VALUES (or VALUE_POS) the entry takes at most in the volume file */
+        int64_t stored_value_size(const EntryT& e) const;
+        /** Copies the entries at KEY_POS of the leaf, the entries copied before are reused */
+        void refresh_inline_entries(const Node& node);
+        /** Encodes the keys of the inline entries of the leaf as the deltas of the smallest one */
+        void refresh_key_frame(const Node& node) const;
+        /** KEY_BASE, KEY_WIDTH and KEY_DELTAS of the leaf of ORDER */
+        int64_t key_frame_size(const int32_t order) const;
+        /** The inline entries of the leaf of ORDER with the key frame */
+        int64_t inline_area_size(const int32_t order) const;
+        /** The slot of WRITTEN_ENTRIES for the entry at POS */
+        size_t written_entry_slot(const int64_t pos) const;
+        int64_t inline_entry_size() const;
+        int64_t value_size_pos(const int64_t entry_pos) const;
+        int64_t align(const int64_t pos) const;
     };
 }
 #include "io_manager_impl.h"
\ No newline at end of file
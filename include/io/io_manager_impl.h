@@ -1,11 +1,29 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include "utils/utils.h"
 #include "utils/error.h"
 
 namespace btree {
     template <typename K, typename V>
-    IOManager<K, V>::IOManager(const std::string& path, const int16_t user_t) : t(user_t), file(path, 0) {}
+    IOManager<K, V>::IOManager(const std::string& path, const int16_t user_t, const int16_t user_buffer_size,
+                               const uint8_t user_flags, const io::FileOptions& file_options,
+                               const int32_t user_value_log_threshold, const int64_t value_log_segment_size,
+                               const int32_t user_compression_threshold) :
+        t(user_t), buffer_size(user_buffer_size), flags(user_flags),
+        alignment(file_options.backend == io::Backend::DIRECT ? io::block_size : 0),
+        internal_t(derive_order(false)), leaf_t(derive_order(true)),
+        node_stride(std::max(internal_node_size_in_bytes(), leaf_size_in_bytes())), file(path, file_options),
+        value_log_threshold(user_value_log_threshold), compression_threshold(user_compression_threshold)
+    {
+        if ((flags & NODE_FILE_FLAG) || has_all_nodes_in_node_file())
+            open_node_file();
+        if (flags & VALUE_LOG_FLAG)
+            value_log = std::make_unique<ValueLog<K, V>>(path + ".vlog", value_log_segment_size);
+    }
 
     template <typename K, typename V>
     int64_t IOManager<K, V>::write_header() {
@@ -13,10 +31,24 @@ namespace btree {
 
         file.write_next_primitive(t);
         file.template write_next_primitive<uint8_t>(sizeof(K));
-        file.template write_next_primitive<uint8_t>(get_value_type_code<V>());
+        file.template write_next_primitive<uint8_t>(get_value_type_code<V>() | (has_extended_header() ? EXTENDED_HEADER_BIT : 0));
         file.template write_next_primitive<uint8_t>(get_element_size<V>());
-        file.write_next_primitive(INITIAL_ROOT_POS_IN_HEADER);
-        return file.get_pos();
+        if (has_extended_header()) {
+            file.write_next_primitive(buffer_size);
+            file.write_next_primitive(flags);
+        }
+        auto root_pos = has_all_nodes_in_node_file() ? NODE_FILE_HEADER_SIZE | NODE_FILE_BIT
+                                                  : align(root_pos_in_header() + sizeof(int64_t));
+        file.write_next_primitive(root_pos);
+        if (node_file) {
+            // the nodes left by the removed volume file aren't reachable
+            node_file->set_pos(NODE_FILE_HEADER_SIZE);
+            node_file->shrink_to_fit();
+        }
+        if (value_log)
+            value_log->clear();
+        decoded_values.clear();
+        return root_pos;
     }
 
     template <typename K, typename V>
@@ -30,26 +62,130 @@ namespace btree {
         validate(key_size == sizeof(K), error_msg::wrong_key_size_msg, file.path);
 
         auto value_type_code = file.read_byte();
-        validate(value_type_code == get_value_type_code<V>(), error_msg::wrong_value_type_msg, file.path);
+        validate((value_type_code & ~EXTENDED_HEADER_BIT) == get_value_type_code<V>(), error_msg::wrong_value_type_msg, file.path);
 
         auto element_size = file.read_byte();
         validate(element_size == get_element_size<V>(), error_msg::wrong_element_size_msg, file.path);
 
-        auto posRoot = file.read_int32();
+        const bool is_extended = (value_type_code & EXTENDED_HEADER_BIT) != 0;
+        auto buffer_size_from_file = is_extended ? file.read_int16() : 0;
+        validate(buffer_size == buffer_size_from_file, error_msg::wrong_buffer_size_msg, file.path);
+
+        auto flags_from_file = is_extended ? file.read_byte() : 0;
+        validate(flags == flags_from_file, error_msg::wrong_flags_msg, file.path);
+
+        auto posRoot = file.read_int64();
         return posRoot;
     }
 
+    template <typename K, typename V>
+    bool IOManager<K, V>::has_extended_header() const {
+        return buffer_size != 0 || flags != 0;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::root_pos_in_header() const {
+        return ROOT_POS_IN_HEADER + (has_extended_header() ? sizeof(buffer_size) + sizeof(flags) : 0);
+    }
+
     template <typename K, typename V>
     bool IOManager<K, V>::is_ready() const {
         return !file.is_empty();
     }
 
+    template <typename K, typename V>
+    int16_t IOManager<K, V>::order(const bool is_leaf) const {
+        return is_leaf ? leaf_t : internal_t;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::allocate_node(const bool is_leaf) {
+        if (node_file && (!is_leaf || has_all_nodes_in_node_file())) {
+            node_file->set_file_pos_to_end();
+            auto pos = node_file->get_pos();
+            // the node of the compact volume takes the slot of NODE_STRIDE bytes, CHILD_POS keeps the slot index
+            if (flags & COMPACT_POS_FLAG)
+                pos = NODE_FILE_HEADER_SIZE + (pos - NODE_FILE_HEADER_SIZE + node_stride - 1) / node_stride * node_stride;
+            return check_compact_pos(pos | NODE_FILE_BIT);
+        }
+        return align(get_file_pos_end());
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::allocate_entry(const EntryT& e) {
+        return check_compact_pos(allocate_entry(e, get_file_pos_end()));
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::allocate_entry(const EntryT& e, const int64_t end) {
+        if (alignment == 0)
+            return end;
+
+        int64_t size = sizeof(K) + ((flags & EXPIRY_FLAG) ? sizeof(int64_t) : 0);
+        size += stored_value_size(e);
+        // the entry that fits in the block is read with one page
+        if (size > alignment || end / alignment != (end + size - 1) / alignment)
+            return align(end);
+        return end;
+    }
+
     template <typename K, typename V>
     void IOManager<K, V>::write_entry(const EntryT& e, const int64_t pos) {
+        write_entry(e, pos, encode_value(e));
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::write_entry(const EntryT& e, const int64_t pos,
+                                      const std::pair<typename EntryT::ValueType, int32_t>& value) {
+        if constexpr(std::is_arithmetic_v<V>) {
+            if (has_inline_entries()) {
+                if (written_entries.empty())
+                    written_entries.resize(written_entry_count, { INVALID_POS, K(), 0, V() });
+                written_entries[written_entry_slot(pos)] = { pos, e.key, e.expires_at, e.data };
+            }
+        }
+        if (flags & COMPRESSION_FLAG)
+            decoded_values.erase(pos);
+        const auto value_pos = is_in_value_log(e) ? value_log->append(e.key, e.data, e.size_in_bytes) : INVALID_POS;
         file.set_pos(pos);
 
         file.write_next_primitive(e.key);
-        file.write_next_data(e.data, e.size_in_bytes);
+        if (flags & EXPIRY_FLAG)
+            file.write_next_primitive(e.expires_at);
+        if (value_pos == INVALID_POS) {
+            file.write_next_data(value.first, value.second);
+            return;
+        }
+        file.write_next_primitive(-e.size_in_bytes);
+        file.write_next_primitive(value_pos);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::overwrite_or_write_entry(const EntryT& e, const int64_t pos) {
+        // the value is encoded once for both places
+        const auto value = encode_value(e);
+        if (overwrite_entry(e, pos, value))
+            return pos;
+
+        const auto entry_pos = allocate_entry(e);
+        write_entry(e, entry_pos, value);
+        return entry_pos;
+    }
+
+    template <typename K, typename V>
+    bool IOManager<K, V>::overwrite_entry(const EntryT& e, const int64_t pos,
+                                          const std::pair<typename EntryT::ValueType, int32_t>& value) {
+        if constexpr(!std::is_arithmetic_v<V>) {
+            file.set_pos(value_size_pos(pos));
+            const auto size = file.read_int32();
+            const auto old_size = static_cast<int64_t>(sizeof(int32_t)) + (size < 0 ? static_cast<int64_t>(sizeof(int64_t)) : size);
+            const auto new_size = static_cast<int64_t>(sizeof(int32_t)) +
+                                  (is_in_value_log(e) ? static_cast<int64_t>(sizeof(int64_t)) : value.second);
+            if (new_size > old_size)
+                return false;
+        }
+        write_entry(e, pos, value);
+        return true;
     }
 
     template <typename K, typename V>
@@ -57,8 +193,34 @@ namespace btree {
         file.set_pos(pos);
 
         K key = file.template read_next_primitive<K>();
+        int64_t expires_at = (flags & EXPIRY_FLAG) ? file.read_int64() : 0;
+        if constexpr(!std::is_arithmetic_v<V>) {
+            if (value_log) {
+                if (file.read_int32() < 0) {
+                    auto [value, size] = value_log->read(file.read_int64());
+                    return { key, value, size, expires_at };
+                }
+                file.set_pos(file.get_pos() - sizeof(int32_t));
+            }
+        }
         auto [value, size] = file.template read_next_data<typename EntryT::ValueType>();
-        return { key, value, size };
+        if constexpr(!std::is_arithmetic_v<V>) {
+            if (flags & COMPRESSION_FLAG) {
+                // the value of the entry is decompressed once
+                auto [it, is_new] = decoded_values.try_emplace(pos);
+                auto& buffer = it->second;
+                if (!is_new && size > 0 && value[0] == static_cast<uint8_t>(io::Codec::ZLIB))
+                    return { key, buffer.data(), static_cast<int32_t>(buffer.size()), expires_at };
+
+                auto [decoded, decoded_size] = io::decode_value(value, size, buffer);
+                // the raw value is in the file, only the decompressed one is kept
+                if (decoded_size < 0 || decoded != buffer.data())
+                    decoded_values.erase(it);
+                validate(decoded_size >= 0, error_msg::wrong_value_codec_msg, file.path);
+                return { key, decoded, decoded_size, expires_at };
+            }
+        }
+        return { key, value, size, expires_at };
     }
 
     template <typename K, typename V>
@@ -68,43 +230,251 @@ namespace btree {
         return file.template read_next_primitive<K>();
     }
 
+    template <typename K, typename V>
+    bool IOManager<K, V>::has_inline_entries() const {
+        return std::is_arithmetic_v<V> && (flags & INLINE_LEAF_FLAG);
+    }
+
+    template <typename K, typename V>
+    bool IOManager<K, V>::has_key_frames() const {
+        return has_inline_entries() && (flags & KEY_FRAME_FLAG);
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::write_inline_entry(const Node& node, const int32_t idx, const EntryT& e) {
+        if constexpr(std::is_arithmetic_v<V>) {
+            with_file(node.m_pos, [this, idx, &e](auto& file, const int64_t file_pos) {
+                file.set_pos(file_pos + node_size_in_bytes(leaf_t) + key_frame_size(leaf_t) + idx * inline_entry_size());
+                // the key of the copy is the same, the key frame isn't changed
+                if (!has_key_frames())
+                    file.write_next_primitive(e.key);
+                if (flags & EXPIRY_FLAG)
+                    file.write_next_primitive(e.expires_at);
+                file.write_next_primitive(e.data);
+            });
+            if (idx < static_cast<int32_t>(node.inline_entries.size()))
+                node.inline_entries[idx] = { node.key_pos[idx], e.key, e.expires_at, e.data };
+        }
+    }
+
+    template <typename K, typename V>
+    ValueLog<K, V>* IOManager<K, V>::get_value_log() {
+        return value_log.get();
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::read_value_pos(const int64_t entry_pos) {
+        if (!value_log)
+            return INVALID_POS;
+
+        file.set_pos(value_size_pos(entry_pos));
+        if (file.read_int32() >= 0)
+            return INVALID_POS;
+        return file.read_int64();
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::write_value_pos(const int64_t entry_pos, const int64_t value_pos) {
+        file.set_pos(value_size_pos(entry_pos) + sizeof(int32_t));
+        file.write_next_primitive(value_pos);
+    }
+
     template <typename K, typename V>
     void IOManager<K, V>::write_new_pos_for_root_node(const int64_t posRoot) {
-        file.set_pos(ROOT_POS_IN_HEADER);
+        file.set_pos(root_pos_in_header());
 
         file.write_next_primitive(posRoot);
     }
 
     template <typename K, typename V>
     void IOManager<K, V>::write_invalidated_root() {
-        file.set_pos(ROOT_POS_IN_HEADER);
+        file.set_pos(root_pos_in_header());
 
         file.write_next_primitive(INVALID_POS);
         file.shrink_to_fit();
+        if (node_file) {
+            node_file->set_pos(NODE_FILE_HEADER_SIZE);
+            node_file->shrink_to_fit();
+        }
+        if (value_log)
+            value_log->clear();
+        decoded_values.clear();
+        written_entries.clear();
     }
 
     template <typename K, typename V>
     int64_t IOManager<K, V>::write_node(const Node& node, const int64_t pos) {
-        file.set_pos(pos);
+        // the moved entries without the copies are read before the node is written: the node can be in the same file
+        const bool has_inline = node.is_leaf && has_inline_entries();
+        if (has_inline)
+            refresh_inline_entries(node);
 
-        file.write_next_primitive(node.is_leaf);
-        file.write_next_primitive(node.used_keys);
-        file.write_node_vector(node.key_pos);
-        file.write_node_vector(node.child_pos);
-        return file.get_pos();
+        return with_file(pos, [this, &node, has_inline](auto& file, const int64_t file_pos) {
+            file.set_pos(file_pos);
+
+            file.write_next_primitive(node.is_leaf);
+            file.write_next_primitive(node.used_keys);
+            write_pos_vector(file, node.key_pos, false);
+            write_pos_vector(file, node.child_pos, true);
+            if (node.has_buffer()) {
+                file.write_next_primitive(node.msg_count);
+                file.write_node_vector(node.msg_keys);
+                write_pos_vector(file, node.msg_pos, false);
+            }
+            if constexpr(std::is_arithmetic_v<V>) {
+                if (has_inline && has_key_frames()) {
+                    refresh_key_frame(node);
+                    const auto& frame = node.key_frame;
+                    file.write_next_primitive(frame.base);
+                    file.write_next_primitive(frame.width);
+                    file.write_node_vector(frame.deltas);
+                    file.write_node_vector(std::vector<uint8_t>(key_frame_size(leaf_t) - sizeof(K) - 1 - frame.deltas.size()));
+                }
+                for (int32_t i = 0; has_inline && i < static_cast<int32_t>(node.key_pos.size()); ++i) {
+                    const bool is_used = i < node.used_keys;
+                    if (!has_key_frames())
+                        file.write_next_primitive(is_used ? node.inline_entries[i].key : K());
+                    if (flags & EXPIRY_FLAG)
+                        file.write_next_primitive(is_used ? node.inline_entries[i].expires_at : int64_t());
+                    file.write_next_primitive(is_used ? node.inline_entries[i].value : V());
+                }
+            }
+            auto end = file.get_pos();
+            if (!node.is_leaf)
+                file.keep_hot(file_pos, end - file_pos);
+            return end;
+        });
     }
 
     template <typename K, typename V>
     BTreeNode <K, V> IOManager<K, V>::read_node(const int64_t pos) {
-        file.set_pos(pos);
+        return with_file(pos, [this, pos](auto& file, const int64_t file_pos) {
+            file.set_pos(file_pos);
+
+            const bool is_leaf = file.read_byte();
+            Node node(order(is_leaf), is_leaf, buffer_size);
+            node.m_pos = pos;
+            node.used_keys = file.read_int16();
+            read_pos_vector(file, node.key_pos, false);
+            read_pos_vector(file, node.child_pos, true);
+            if (node.has_buffer()) {
+                node.msg_count = file.read_int16();
+                file.read_node_vector(node.msg_keys);
+                read_pos_vector(file, node.msg_pos, false);
+            }
+            if constexpr(std::is_arithmetic_v<V>) {
+                auto& frame = node.key_frame;
+                if (node.is_leaf && has_key_frames()) {
+                    const auto frame_pos = file.get_pos();
+                    frame.base = file.template read_next_primitive<K>();
+                    frame.width = file.read_byte();
+                    frame.deltas.resize(static_cast<size_t>(node.used_keys) * frame.width);
+                    file.read_node_vector(frame.deltas);
+                    file.set_pos(frame_pos + key_frame_size(leaf_t));
+                }
+                // the leaf of the keys that don't fit in the key frame is read through the entries
+                if (node.is_leaf && has_inline_entries() && (!has_key_frames() || frame.width > 0)) {
+                    node.inline_entries.resize(node.used_keys);
+                    for (int32_t i = 0; i < node.used_keys; ++i) {
+                        auto& e = node.inline_entries[i];
+                        e.pos = node.key_pos[i];
+                        e.key = has_key_frames() ? frame.key(i) : file.template read_next_primitive<K>();
+                        e.expires_at = (flags & EXPIRY_FLAG) ? file.read_int64() : 0;
+                        e.value = file.template read_next_primitive<V>();
+                    }
+                }
+            }
+            if (!node.is_leaf)
+                file.keep_hot(file_pos, file.get_pos() - file_pos);
+            return node;
+        });
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::prefetch(const int64_t pos) {
+        with_file(pos, [](auto& file, const int64_t file_pos) { file.prefetch(file_pos); });
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::prefetch_node(const int64_t node_pos) {
+        with_file(node_pos, [this](auto& file, const int64_t file_pos) {
+            file.prefetch(file_pos, std::max(internal_node_size_in_bytes(), leaf_size_in_bytes()));
+        });
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::submit_prefetches() {
+        file.submit_prefetches();
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::keep_internal_node(const int64_t node_pos) {
+        with_file(node_pos, [this](auto& file, const int64_t file_pos) {
+            file.keep_hot(file_pos, internal_node_size_in_bytes());
+        });
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::advise(const io::Advice advice) {
+        file.advise(advice);
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::advise(const int64_t pos, const int64_t size, const io::Advice advice) const {
+        file.advise(pos, size, advice);
+    }
+
+    template <typename K, typename V>
+    template <typename T>
+    T IOManager<K, V>::read_at(const int64_t pos) {
+        return with_file(pos, [](auto& file, const int64_t file_pos) {
+            file.set_pos(file_pos);
+            return file.template read_next_primitive<T>();
+        });
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::read_entry_pos_at(const int64_t pos) {
+        if (flags & COMPACT_POS_FLAG)
+            return from_compact_entry_pos(read_at<uint32_t>(pos) | (uint64_t(read_at<uint16_t>(pos + sizeof(uint32_t))) << 32));
+        return read_at<int64_t>(pos);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::read_child_pos_at(const int64_t pos) {
+        if (flags & COMPACT_POS_FLAG)
+            return from_compact_child_pos(read_at<uint32_t>(pos));
+        return read_at<int64_t>(pos);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::used_keys_pos(const int64_t node_pos) const {
+        return node_pos + sizeof(uint8_t);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::key_pos_pos(const int64_t node_pos, const int32_t idx) const {
+        return used_keys_pos(node_pos) + sizeof(int16_t) + idx * entry_pos_size();
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::child_pos_pos(const int64_t node_pos, const int32_t idx) const {
+        return key_pos_pos(node_pos, 2 * internal_t - 1) + idx * child_pos_size();
+    }
 
-        Node node(t, false);
-        node.m_pos = pos;
-        node.is_leaf = file.read_byte();
-        node.used_keys = file.read_int16();
-        file.read_node_vector(node.key_pos);
-        file.read_node_vector(node.child_pos);
-        return node;
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::msg_count_pos(const int64_t node_pos) const {
+        return child_pos_pos(node_pos, 2 * internal_t);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::msg_key_pos(const int64_t node_pos, const int32_t idx) const {
+        return msg_count_pos(node_pos) + sizeof(int16_t) + idx * sizeof(K);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::msg_pos_pos(const int64_t node_pos, const int32_t idx) const {
+        return msg_key_pos(node_pos, buffer_size) + idx * entry_pos_size();
     }
 
     template <typename K, typename V>
@@ -112,4 +482,283 @@ namespace btree {
         file.set_file_pos_to_end();
         return file.get_pos();
     }
-}
\ No newline at end of file
+
+    template <typename K, typename V>
+    void IOManager<K, V>::open_node_file() {
+        node_file = std::make_unique<MappedFile<K, V>>(file.path + ".nodes", 0);
+        if (flags & NODE_FILE_FLAG)
+            node_file->use_huge_pages();
+        // the index file is small enough to be resident, it's read ahead after every remap
+        if (has_all_nodes_in_node_file())
+            node_file->advise(io::Advice::WILLNEED);
+        if (node_file->is_empty()) {
+            node_file->write_next_primitive(NODE_FILE_MAGIC);
+            return;
+        }
+        node_file->set_pos(0);
+        validate(node_file->read_int64() == NODE_FILE_MAGIC, error_msg::wrong_node_file_msg, node_file->path);
+    }
+
+    template <typename K, typename V>
+    bool IOManager<K, V>::has_all_nodes_in_node_file() const {
+        return flags & (INDEX_FILE_FLAG | COMPACT_POS_FLAG);
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    auto IOManager<K, V>::with_file(const int64_t pos, Fn&& fn) {
+        if (pos >= 0 && (pos & NODE_FILE_BIT))
+            return fn(*node_file, pos & ~NODE_FILE_BIT);
+        return fn(file, pos);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::page_size_in_bytes() const {
+        return Node::get_node_size_in_bytes(t);
+    }
+
+    template <typename K, typename V>
+    int16_t IOManager<K, V>::derive_order(const bool is_leaf) const {
+        auto size = [this, is_leaf](const int32_t order) {
+            return node_size_in_bytes(order) + (is_leaf ? inline_area_size(order) : 0);
+        };
+        // the plain layout keeps the order T
+        int32_t order = std::min<int32_t>(t, 2);
+        while (order < std::numeric_limits<int16_t>::max() && size(order + 1) <= page_size_in_bytes())
+            ++order;
+        return static_cast<int16_t>(order);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::internal_node_size_in_bytes() const {
+        const int64_t buffer_size_in_bytes = buffer_size > 0 ? sizeof(int16_t) + buffer_size * (sizeof(K) + entry_pos_size()) : 0;
+        return node_size_in_bytes(internal_t) + buffer_size_in_bytes;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::leaf_size_in_bytes() const {
+        return node_size_in_bytes(leaf_t) + inline_area_size(leaf_t);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::node_size_in_bytes(const int32_t order) const {
+        if (flags & COMPACT_POS_FLAG)
+            return sizeof(uint8_t) + sizeof(int16_t) + (2 * order - 1) * entry_pos_size() + 2 * order * child_pos_size();
+        return Node::get_node_size_in_bytes(order);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::entry_pos_size() const {
+        return (flags & COMPACT_POS_FLAG) ? COMPACT_ENTRY_POS_SIZE : sizeof(int64_t);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::child_pos_size() const {
+        return (flags & COMPACT_POS_FLAG) ? sizeof(uint32_t) : sizeof(int64_t);
+    }
+
+    template <typename K, typename V>
+    template <typename File>
+    void IOManager<K, V>::write_pos_vector(File& file, const std::vector<int64_t>& vec, const bool is_child) const {
+        if (!(flags & COMPACT_POS_FLAG))
+            return file.write_node_vector(vec);
+
+        if (is_child) {
+            std::vector<uint32_t> compact(vec.size());
+            std::transform(vec.begin(), vec.end(), compact.begin(), [this](auto pos) { return to_compact_child_pos(pos); });
+            return file.write_node_vector(compact);
+        }
+        // the low 6 bytes of the entry position
+        std::vector<uint8_t> compact(vec.size() * COMPACT_ENTRY_POS_SIZE);
+        for (size_t i = 0; i < vec.size(); ++i) {
+            const auto pos = to_compact_entry_pos(vec[i]);
+            for (int64_t byte = 0; byte < COMPACT_ENTRY_POS_SIZE; ++byte)
+                compact[i * COMPACT_ENTRY_POS_SIZE + byte] = static_cast<uint8_t>(pos >> (8 * byte));
+        }
+        file.write_node_vector(compact);
+    }
+
+    template <typename K, typename V>
+    template <typename File>
+    void IOManager<K, V>::read_pos_vector(File& file, std::vector<int64_t>& vec, const bool is_child) const {
+        if (!(flags & COMPACT_POS_FLAG))
+            return file.read_node_vector(vec);
+
+        if (is_child) {
+            std::vector<uint32_t> compact(vec.size());
+            file.read_node_vector(compact);
+            std::transform(compact.begin(), compact.end(), vec.begin(), [this](auto pos) { return from_compact_child_pos(pos); });
+            return;
+        }
+        std::vector<uint8_t> compact(vec.size() * COMPACT_ENTRY_POS_SIZE);
+        file.read_node_vector(compact);
+        for (size_t i = 0; i < vec.size(); ++i) {
+            uint64_t pos = 0;
+            for (int64_t byte = 0; byte < COMPACT_ENTRY_POS_SIZE; ++byte)
+                pos |= uint64_t(compact[i * COMPACT_ENTRY_POS_SIZE + byte]) << (8 * byte);
+            vec[i] = from_compact_entry_pos(pos);
+        }
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::check_compact_pos(const int64_t pos) const {
+        if (!(flags & COMPACT_POS_FLAG))
+            return pos;
+        if (pos & NODE_FILE_BIT)
+            validate(to_node_index(pos) < COMPACT_NODE_LIMIT, error_msg::compact_pos_overflow_msg, node_file->path);
+        else
+            validate(pos < COMPACT_ENTRY_POS_LIMIT, error_msg::compact_pos_overflow_msg, file.path);
+        return pos;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::to_node_index(const int64_t pos) const {
+        return ((pos & ~NODE_FILE_BIT) - NODE_FILE_HEADER_SIZE) / node_stride;
+    }
+
+    template <typename K, typename V>
+    uint32_t IOManager<K, V>::to_compact_child_pos(const int64_t pos) const {
+        // the allocations are checked against COMPACT_NODE_LIMIT, so the index fits in 32 bits
+        if (pos == INVALID_POS)
+            return static_cast<uint32_t>(COMPACT_NODE_LIMIT);
+        return static_cast<uint32_t>(to_node_index(pos));
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::from_compact_child_pos(const uint32_t pos) const {
+        if (pos == COMPACT_NODE_LIMIT)
+            return INVALID_POS;
+        return (NODE_FILE_HEADER_SIZE + pos * node_stride) | NODE_FILE_BIT;
+    }
+
+    template <typename K, typename V>
+    uint64_t IOManager<K, V>::to_compact_entry_pos(const int64_t pos) const {
+        // the allocations are checked against COMPACT_ENTRY_POS_LIMIT, so the offset fits in 48 bits
+        return pos == INVALID_POS ? COMPACT_ENTRY_POS_LIMIT : static_cast<uint64_t>(pos);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::from_compact_entry_pos(const uint64_t pos) const {
+        return pos == COMPACT_ENTRY_POS_LIMIT ? INVALID_POS : static_cast<int64_t>(pos);
+    }
+
+    template <typename K, typename V>
+    bool IOManager<K, V>::is_in_value_log(const EntryT& e) const {
+        if constexpr(std::is_arithmetic_v<V>)
+            return false;
+        else
+            return value_log && e.size_in_bytes >= value_log_threshold;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::stored_value_size(const EntryT& e) const {
+        if constexpr(std::is_arithmetic_v<V>)
+            return sizeof(V);
+        else if (is_in_value_log(e))
+            return sizeof(int32_t) + sizeof(int64_t);
+        else // the value is compressed only if it gets smaller
+            return sizeof(int32_t) + ((flags & COMPRESSION_FLAG) ? 1 : 0) + e.size_in_bytes;
+    }
+
+    template <typename K, typename V>
+    std::pair<typename BTree<K, V>::EntryT::ValueType, int32_t> IOManager<K, V>::encode_value(const EntryT& e) {
+        if constexpr(!std::is_arithmetic_v<V>) {
+            if ((flags & COMPRESSION_FLAG) && !is_in_value_log(e)) {
+                io::encode_value(e.data, e.size_in_bytes, compression_threshold, value_buffer);
+                return { value_buffer.data(), static_cast<int32_t>(value_buffer.size()) };
+            }
+        }
+        return { e.data, e.size_in_bytes };
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::refresh_inline_entries(const Node& node) {
+        if constexpr(std::is_arithmetic_v<V>) {
+            const auto& old_entries = node.inline_entries;
+            const auto old_count = static_cast<int32_t>(old_entries.size());
+            std::vector<typename Node::InlineEntry> entries(node.used_keys);
+            for (int32_t i = 0; i < node.used_keys; ++i) {
+                const auto pos = node.key_pos[i];
+                // the keys are shifted by one at most, the moved keys of the split|merge are looked for
+                auto j = (i < old_count && old_entries[i].pos == pos) ? i :
+                         (i > 0 && i - 1 < old_count && old_entries[i - 1].pos == pos) ? i - 1 :
+                         (i + 1 < old_count && old_entries[i + 1].pos == pos) ? i + 1 : -1;
+                for (int32_t k = 0; j < 0 && k < old_count; ++k) {
+                    if (old_entries[k].pos == pos)
+                        j = k;
+                }
+                if (j >= 0) {
+                    entries[i] = old_entries[j];
+                } else if (!written_entries.empty() && written_entries[written_entry_slot(pos)].pos == pos) {
+                    // the new entry of the leaf has just been written
+                    entries[i] = written_entries[written_entry_slot(pos)];
+                } else {
+                    auto e = read_entry(pos);
+                    entries[i] = { pos, e.key, e.expires_at, e.data };
+                }
+            }
+            node.inline_entries = std::move(entries);
+        }
+    }
+
+    template <typename K, typename V>
+    void IOManager<K, V>::refresh_key_frame(const Node& node) const {
+        using U = std::make_unsigned_t<K>;
+        const auto& entries = node.inline_entries;
+        auto& frame = node.key_frame;
+        frame.base = entries.empty() ? K() : entries.front().key;
+        auto delta = [&frame](const K key) {
+            return static_cast<uint64_t>(static_cast<U>(static_cast<U>(key) - static_cast<U>(frame.base)));
+        };
+        // the keys are sorted, so the last one has the biggest delta
+        const uint64_t range = entries.empty() ? 0 : entries.back().key < frame.base ? UINT64_MAX : delta(entries.back().key);
+        frame.width = range <= UINT8_MAX ? 1 : range <= UINT16_MAX ? 2 : range <= UINT32_MAX ? 4 : 0;
+        if (frame.width > sizeof(K) / 2)
+            frame.width = 0;
+
+        frame.deltas.resize(entries.size() * frame.width);
+        auto set_delta = [&frame](const size_t idx, auto delta) {
+            std::memcpy(frame.deltas.data() + idx * sizeof(delta), &delta, sizeof(delta));
+        };
+        for (size_t i = 0; frame.width > 0 && i < entries.size(); ++i) {
+            const auto d = delta(entries[i].key);
+            if (frame.width == 1)
+                set_delta(i, static_cast<uint8_t>(d));
+            else if (frame.width == 2)
+                set_delta(i, static_cast<uint16_t>(d));
+            else
+                set_delta(i, static_cast<uint32_t>(d));
+        }
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::key_frame_size(const int32_t order) const {
+        return has_key_frames() ? sizeof(K) + sizeof(uint8_t) + (2 * order - 1) * (sizeof(K) / 2) : 0;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::inline_area_size(const int32_t order) const {
+        return has_inline_entries() ? key_frame_size(order) + (2 * order - 1) * inline_entry_size() : 0;
+    }
+
+    template <typename K, typename V>
+    size_t IOManager<K, V>::written_entry_slot(const int64_t pos) const {
+        return static_cast<size_t>(pos / inline_entry_size()) % written_entry_count;
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::inline_entry_size() const {
+        return (has_key_frames() ? 0 : sizeof(K)) + ((flags & EXPIRY_FLAG) ? sizeof(int64_t) : 0) +
+               (std::is_arithmetic_v<V> ? sizeof(V) : 0);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::value_size_pos(const int64_t entry_pos) const {
+        return entry_pos + sizeof(K) + ((flags & EXPIRY_FLAG) ? sizeof(int64_t) : 0);
+    }
+
+    template <typename K, typename V>
+    int64_t IOManager<K, V>::align(const int64_t pos) const {
+        return alignment == 0 ? pos : (pos + alignment - 1) / alignment * alignment;
+    }
+}
@@ -3,6 +3,7 @@
 #include <string>
 #include <fstream>
 
+#include "backend.h"
 #include "utils/boost_include.h"
 #include "utils/utils.h"
 
@@ -12,10 +13,17 @@ namespace btree {
         class MappedRegion {
             bip::mapped_region mapped_region;
             uint8_t* mapped_region_begin;
+            io::Advice advice;
+            bool huge_pages;
         public:
             explicit MappedRegion();
             uint8_t* address_by_offset(const int64_t offset) const;
+            /** The advice of the region is applied to the new mapping */
             void remap(const std::string& path);
+            void advise(const io::Advice new_advice);
+            void advise(const int64_t offset, const int64_t size, const io::Advice range_advice) const;
+            io::Advice get_advice() const;
+            void use_huge_pages();
         };
 
         using ValueType = utils::conditional_t<std::is_arithmetic_v<V>, const V, const uint8_t*>;
@@ -23,6 +31,7 @@ namespace btree {
         int64_t m_pos;
         int64_t m_size;
         int64_t m_capacity;
+        int64_t m_size_step;
         std::unique_ptr<MappedRegion> m_mapped_region;
     public:
         // todo: fix
@@ -53,6 +62,28 @@ namespace btree {
         template <typename T>
         void read_node_vector(std::vector<T>& vec);
 
+        /**
+         * Prefetches the cache line of the byte at POS, doesn't move the current pos.
+         * Only the first line of the range is prefetched, the hardware prefetcher follows the sequential reads.
+         * The file advised with io::Advice::RANDOM has no readahead: the range of several pages (the node)
+         * is advised with WILLNEED, so it's read at once instead of a page fault per page.
+         */
+        void prefetch(const int64_t pos, const int64_t size = 1) const;
+        /** The prefetches of the mapping are issued at once, there is nothing to submit */
+        void submit_prefetches() {}
+        /** The eviction of the mapped pages is up to the kernel */
+        void keep_hot(const int64_t, const int64_t) {}
+
+        /** The advice of the whole file, it's kept by the remaps */
+        void advise(const io::Advice advice);
+        /** The advice of the range of the current mapping */
+        void advise(const int64_t pos, const int64_t size, const io::Advice advice) const;
+        /**
+         * The mapping is advised with MADV_HUGEPAGE and the file grows by io::huge_page_size, so the kernel
+         * can map it with the transparent huge pages (if the file system supports the large folios)
+         */
+        void use_huge_pages();
+
         int64_t get_pos() const;
         void set_pos(int64_t pos);
         void set_file_pos_to_end();
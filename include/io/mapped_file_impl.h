@@ -2,6 +2,9 @@
 
 #include <filesystem>
 #include <iostream>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 
 #include "utils/utils.h"
 
@@ -28,7 +31,7 @@ namespace file {
 
     template <typename K, typename V>
     MappedFile<K,V>::MappedFile(const std::string& path, const int64_t bytes_num) :
-            m_pos(0), m_mapped_region(new MappedRegion()), path(path)
+            m_pos(0), m_size_step(1), m_mapped_region(new MappedRegion()), path(path)
     {
         bool file_exists = fs::exists(path);
         if (!file_exists) {
@@ -67,7 +70,8 @@ namespace file {
     }
 
     template <typename K, typename V>
-    MappedFile<K,V>::MappedRegion::MappedRegion() : mapped_region_begin(nullptr) {}
+    MappedFile<K,V>::MappedRegion::MappedRegion() :
+        mapped_region_begin(nullptr), advice(io::Advice::NORMAL), huge_pages(false) {}
 
     template <typename K, typename V>
     uint8_t* MappedFile<K,V>::MappedRegion::address_by_offset(const int64_t offset) const {
@@ -80,6 +84,64 @@ namespace file {
         auto tmp_mapped_region = bip::mapped_region(file_mapping, bip::read_write);
         mapped_region.swap(tmp_mapped_region);
         mapped_region_begin = cast_to_uint8_t_data(mapped_region.get_address());
+        if (advice != io::Advice::NORMAL)
+            advise(advice);
+        if (huge_pages)
+            use_huge_pages();
+    }
+
+    template <typename K, typename V>
+    void MappedFile<K,V>::MappedRegion::use_huge_pages() {
+        huge_pages = true;
+#if defined(MADV_HUGEPAGE)
+        if (mapped_region_begin)
+            ::madvise(mapped_region_begin, mapped_region.get_size(), MADV_HUGEPAGE);
+#endif
+    }
+
+    template <typename K, typename V>
+    void MappedFile<K,V>::MappedRegion::advise(const io::Advice new_advice) {
+        advice = new_advice;
+        if (!mapped_region_begin)
+            return;
+        switch (advice) {
+            case io::Advice::NORMAL: mapped_region.advise(bip::mapped_region::advice_normal); break;
+            case io::Advice::RANDOM: mapped_region.advise(bip::mapped_region::advice_random); break;
+            case io::Advice::SEQUENTIAL: mapped_region.advise(bip::mapped_region::advice_sequential); break;
+            case io::Advice::WILLNEED: mapped_region.advise(bip::mapped_region::advice_willneed); break;
+        }
+    }
+
+    template <typename K, typename V>
+    void MappedFile<K,V>::MappedRegion::advise(const int64_t offset, const int64_t size,
+                                                const io::Advice range_advice) const
+    {
+#if defined(_WIN32)
+        // the advice is ignored like bip::mapped_region::advise(...) does on Windows
+        (void)offset; (void)size; (void)range_advice;
+#else
+        if (!mapped_region_begin || size <= 0)
+            return;
+        // madvise takes the page aligned address, the region itself is page aligned
+        const auto page_size = static_cast<int64_t>(bip::mapped_region::get_page_size());
+        const auto begin = offset / page_size * page_size;
+        const auto end = std::min<int64_t>(offset + size, static_cast<int64_t>(mapped_region.get_size()));
+        if (begin >= end)
+            return;
+        int unix_advice = POSIX_MADV_NORMAL;
+        switch (range_advice) {
+            case io::Advice::NORMAL: unix_advice = POSIX_MADV_NORMAL; break;
+            case io::Advice::RANDOM: unix_advice = POSIX_MADV_RANDOM; break;
+            case io::Advice::SEQUENTIAL: unix_advice = POSIX_MADV_SEQUENTIAL; break;
+            case io::Advice::WILLNEED: unix_advice = POSIX_MADV_WILLNEED; break;
+        }
+        ::posix_madvise(mapped_region_begin + begin, static_cast<size_t>(end - begin), unix_advice);
+#endif
+    }
+
+    template <typename K, typename V>
+    io::Advice MappedFile<K,V>::MappedRegion::get_advice() const {
+        return advice;
     }
 
     template <typename K, typename V>
@@ -184,6 +246,8 @@ namespace file {
     void MappedFile<K,V>::resize(int64_t new_size, bool shrink_to_fit) {
         // Can't use std::filesystem::resize_file(), see file_mapping_impl.h: ~MappedFile() {...}
         m_size = shrink_to_fit ? new_size : std::max(scale_current_size(), new_size);
+        if (!shrink_to_fit)
+            m_size = (m_size + m_size_step - 1) / m_size_step * m_size_step;
         std::filesystem::resize_file(path, m_size);
 //        file::seek_file_to_offset(path, std::ios_base::in | std::ios_base::out, m_size);
         m_mapped_region->remap(path);
@@ -214,6 +278,32 @@ namespace file {
         return m_pos;
     }
 
+    template <typename K, typename V>
+    void MappedFile<K,V>::prefetch(const int64_t pos, const int64_t size) const {
+        if (pos < 0 || pos >= m_size)
+            return;
+        const auto page_size = static_cast<int64_t>(bip::mapped_region::get_page_size());
+        if (m_mapped_region->get_advice() == io::Advice::RANDOM && pos / page_size != (pos + size - 1) / page_size)
+            m_mapped_region->advise(pos, size, io::Advice::WILLNEED);
+        utils::prefetch(m_mapped_region->address_by_offset(pos));
+    }
+
+    template <typename K, typename V>
+    void MappedFile<K,V>::advise(const io::Advice advice) {
+        m_mapped_region->advise(advice);
+    }
+
+    template <typename K, typename V>
+    void MappedFile<K,V>::advise(const int64_t pos, const int64_t size, const io::Advice advice) const {
+        m_mapped_region->advise(pos, size, advice);
+    }
+
+    template <typename K, typename V>
+    void MappedFile<K,V>::use_huge_pages() {
+        m_size_step = io::huge_page_size;
+        m_mapped_region->use_huge_pages();
+    }
+
     template <typename K, typename V>
     uint8_t MappedFile<K,V>::read_byte() {
         return read_next_primitive<uint8_t>();
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <list>
+#include <new>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "backend.h"
+#include "file_handle.h"
+#include "batch_reader.h"
+
+namespace btree::io {
+    /**
+     * User-space write-back cache of the file pages:
+     *  - the least recently used page is evicted when the cache is full, the dirty page is written back first
+     *  - flush() writes all the dirty pages in the ascending order of their positions, so the order of writes
+     *    is controlled by the cache instead of the kernel writeback of the mapped pages
+     *  - prefetch(...) collects the missing pages, load_prefetched(...) reads them in one batch (see BatchReader)
+     *  - the pages of the internal nodes (keep_hot(...)) are evicted after all the other pages, so the scan
+     *    of the values doesn't push the upper levels of the tree out; they take at most 3/4 of the cache
+     *  - the page buffers are aligned to the page size for the direct I/O
+     */
+    class PageCache final {
+    public:
+        static constexpr int64_t page_size = block_size;
+    private:
+        struct AlignedDelete {
+            void operator()(uint8_t* ptr) const {
+                ::operator delete[](ptr, std::align_val_t(page_size));
+            }
+        };
+
+        struct Page {
+            int64_t id = -1;
+            bool is_dirty = false;
+            bool is_hot = false;
+            std::unique_ptr<uint8_t[], AlignedDelete> data;
+        };
+
+        const FileHandle& file;
+        const size_t capacity;
+        const size_t hot_capacity;
+        std::vector<Page> pages;
+        // the slots of the pages from the most to the least recently used one: the pages of the internal nodes
+        // and the rest of the pages, the victim is taken from the cold list first
+        std::list<size_t> hot_lru;
+        std::list<size_t> cold_lru;
+        std::unordered_map<int64_t, std::list<size_t>::iterator> slot_by_id;
+        std::vector<int64_t> prefetched_ids;
+    public:
+        PageCache(const FileHandle& file, const size_t capacity_in_bytes) :
+            file(file), capacity(std::max<size_t>(capacity_in_bytes / page_size, 1)),
+            hot_capacity(capacity - capacity / 4) {}
+
+        void read(int64_t pos, uint8_t* dst, int64_t n) {
+            while (n > 0) {
+                auto& page = get(pos / page_size, true);
+                auto offset = pos % page_size;
+                auto len = std::min(n, page_size - offset);
+                std::copy(page.data.get() + offset, page.data.get() + offset + len, dst);
+                pos += len;
+                dst += len;
+                n -= len;
+            }
+        }
+
+        void write(int64_t pos, const uint8_t* src, int64_t n) {
+            while (n > 0) {
+                auto offset = pos % page_size;
+                auto len = std::min(n, page_size - offset);
+                // the page that is overwritten completely isn't read
+                auto& page = get(pos / page_size, len < page_size);
+                std::copy(src, src + len, page.data.get() + offset);
+                page.is_dirty = true;
+                pos += len;
+                src += len;
+                n -= len;
+            }
+        }
+
+        void prefetch(const int64_t pos, const int64_t n) {
+            if (pos < 0)
+                return;
+            for (auto id = pos / page_size; id <= (pos + std::max<int64_t>(n, 1) - 1) / page_size; ++id) {
+                if (slot_by_id.count(id) == 0)
+                    prefetched_ids.push_back(id);
+            }
+        }
+
+        /** Reads the prefetched pages at once, the batch is cut to a half of the cache, so it doesn't evict itself */
+        void load_prefetched(BatchReader& reader) {
+            if (prefetched_ids.empty())
+                return;
+            std::sort(prefetched_ids.begin(), prefetched_ids.end());
+            prefetched_ids.erase(std::unique(prefetched_ids.begin(), prefetched_ids.end()), prefetched_ids.end());
+            prefetched_ids.resize(std::min(prefetched_ids.size(), std::max<size_t>(capacity / 2, 1)));
+
+            std::vector<ReadRequest> requests;
+            for (const auto id: prefetched_ids) {
+                if (slot_by_id.count(id) != 0)
+                    continue;
+                auto& page = acquire(id);
+                requests.push_back(ReadRequest{ id * page_size, page.data.get(), page_size });
+            }
+            prefetched_ids.clear();
+
+            try {
+                reader.read(file, requests);
+            } catch (...) {
+                for (const auto& request: requests)
+                    drop(request.pos / page_size);
+                throw;
+            }
+        }
+
+        /** The cached pages of [POS, POS + SIZE) hold the internal node, they are evicted last */
+        void keep_hot(const int64_t pos, const int64_t n) {
+            for (auto id = pos / page_size; id <= (pos + std::max<int64_t>(n, 1) - 1) / page_size; ++id) {
+                auto it = slot_by_id.find(id);
+                if (it == slot_by_id.end() || pages[*it->second].is_hot)
+                    continue;
+                if (hot_lru.size() >= hot_capacity) {
+                    // the least recently used internal page goes back to the cold pages
+                    pages[hot_lru.back()].is_hot = false;
+                    cold_lru.splice(cold_lru.begin(), hot_lru, std::prev(hot_lru.end()));
+                }
+                pages[*it->second].is_hot = true;
+                hot_lru.splice(hot_lru.begin(), cold_lru, it->second);
+            }
+        }
+
+        bool is_cached(const int64_t pos) const {
+            return slot_by_id.count(pos / page_size) != 0;
+        }
+
+        void flush() {
+            std::vector<Page*> dirty;
+            for (auto& page: pages) {
+                if (page.is_dirty)
+                    dirty.push_back(&page);
+            }
+            std::sort(dirty.begin(), dirty.end(), [](const Page* lhs, const Page* rhs) { return lhs->id < rhs->id; });
+            for (auto* page: dirty)
+                write_back(*page);
+        }
+
+        /** Drops the pages at or after POS without writing them back, the file is truncated by the caller */
+        void discard_from(const int64_t pos) {
+            for (auto it = slot_by_id.begin(); it != slot_by_id.end();) {
+                auto& page = pages[*it->second];
+                if (page.id * page_size + page_size <= pos) {
+                    ++it;
+                    continue;
+                }
+                if (page.id * page_size < pos) {
+                    // the part of the page before POS is kept
+                    std::fill(page.data.get() + pos % page_size, page.data.get() + page_size, 0);
+                    ++it;
+                    continue;
+                }
+                drop((it++)->first);
+            }
+        }
+
+    private:
+        Page& get(const int64_t id, const bool must_read) {
+            auto it = slot_by_id.find(id);
+            if (it != slot_by_id.end()) {
+                auto& lru = lru_of(pages[*it->second]);
+                lru.splice(lru.begin(), lru, it->second);
+                return pages[*it->second];
+            }
+
+            auto& page = acquire(id);
+            if (must_read) {
+                try {
+                    file.read(id * page_size, page.data.get(), page_size);
+                } catch (...) {
+                    drop(id);
+                    throw;
+                }
+            }
+            return page;
+        }
+
+        /** Takes the free or the least recently used slot for the page, the page data isn't read */
+        Page& acquire(const int64_t id) {
+            size_t slot;
+            if (pages.size() < capacity) {
+                slot = pages.size();
+                auto* data = static_cast<uint8_t*>(::operator new[](page_size, std::align_val_t(page_size)));
+                pages.push_back(Page{ -1, false, false, std::unique_ptr<uint8_t[], AlignedDelete>(data) });
+                cold_lru.push_front(slot);
+            } else {
+                auto& victim_lru = cold_lru.empty() ? hot_lru : cold_lru;
+                slot = victim_lru.back();
+                cold_lru.splice(cold_lru.begin(), victim_lru, std::prev(victim_lru.end()));
+                auto& victim = pages[slot];
+                if (victim.id != -1) {
+                    write_back(victim);
+                    slot_by_id.erase(victim.id);
+                }
+            }
+            slot_by_id[id] = cold_lru.begin();
+
+            auto& page = pages[slot];
+            page.id = id;
+            page.is_dirty = false;
+            page.is_hot = false;
+            return page;
+        }
+
+        /** The page that failed to be read is forgotten */
+        void drop(const int64_t id) {
+            auto it = slot_by_id.find(id);
+            if (it == slot_by_id.end())
+                return;
+            auto& page = pages[*it->second];
+            cold_lru.splice(cold_lru.end(), lru_of(page), it->second);
+            page.id = -1;
+            page.is_dirty = false;
+            page.is_hot = false;
+            slot_by_id.erase(it);
+        }
+
+        std::list<size_t>& lru_of(const Page& page) {
+            return page.is_hot ? hot_lru : cold_lru;
+        }
+
+        void write_back(Page& page) {
+            if (!page.is_dirty)
+                return;
+            file.write(page.id * page_size, page.data.get(), page_size);
+            page.is_dirty = false;
+        }
+    };
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "file_handle.h"
+#include "backend.h"
+#include "page_cache.h"
+#include "utils/utils.h"
+
+namespace btree {
+    /**
+     * Explicit I/O backend of the volume file (io::Backend::PREAD|DIRECT), it has the interface of MappedFile:
+     *  - the file is read and written with pread|pwrite through the user-space PageCache instead of the mapping,
+     *    so the failed I/O throws instead of SIGBUS and there are no page faults on the queries
+     *  - the dirty pages are written back on eviction and in the ascending order when the file is closed
+     *  - the prefetched pages are read in batches through io_uring or the read pool (see BatchReader)
+     *  - io::Backend::DIRECT opens the file for the direct I/O: only whole aligned pages are read and written
+     *  - the file format is the same, the volume can be reopened with another backend
+     *  - the string and blob values are copied to the ring of value buffers: the pointer of the read value
+     *    is valid for the next value_buffer_count reads of values (until the remap for MappedFile), so the batch
+     *    queries copy the blobs (see Volume::multi_get)
+     */
+    template <typename K, typename V>
+    class PositionalFile {
+        using ValueType = utils::conditional_t<std::is_arithmetic_v<V>, const V, const uint8_t*>;
+
+        static constexpr size_t value_buffer_count = 1024;
+
+        int64_t m_pos;
+        int64_t m_capacity;
+        io::FileHandle handle;
+        io::PageCache cache;
+        io::BatchReader reader;
+        std::array<std::vector<uint8_t>, value_buffer_count> value_buffers;
+        size_t next_value_buffer;
+    public:
+        const std::string path;
+
+        PositionalFile(const std::string& path, const io::FileOptions& options) :
+            m_pos(0), m_capacity(0), handle(path, options.backend == io::Backend::DIRECT), cache(handle, options.page_cache_size_in_bytes),
+            reader(options.use_io_uring), next_value_buffer(0), path(path)
+        {
+            m_capacity = handle.size();
+        }
+
+        /**
+         * The file is flushed and cut to the written size. The destructor doesn't throw: the failed write-back
+         * of the pages evicted before is thrown by the query that evicts them
+         */
+        ~PositionalFile() {
+            try {
+                cache.flush();
+                handle.truncate(m_capacity);
+            } catch (...) {}
+        }
+
+        template <typename ValueType>
+        std::pair<ValueType, int32_t> read_next_data() {
+            if constexpr(std::is_pointer_v<ValueType>) {
+                auto len = read_next_primitive<int32_t>();
+                auto& buffer = value_buffers[next_value_buffer];
+                next_value_buffer = (next_value_buffer + 1) % value_buffer_count;
+                buffer.resize(len);
+                read(buffer.data(), len);
+                return std::make_pair(buffer.data(), len);
+            } else {
+                static_assert(std::is_arithmetic_v<ValueType>);
+                return std::make_pair(read_next_primitive<ValueType>(), static_cast<int32_t>(sizeof(ValueType)));
+            }
+        }
+
+        template <typename T>
+        void write_next_primitive(const T val) {
+            static_assert(std::is_arithmetic_v<T>);
+            write(utils::cast_to_const_uint8_t_data(&val), sizeof(T));
+        }
+
+        template <typename T>
+        T read_next_primitive() {
+            static_assert(std::is_arithmetic_v<T>);
+            if (m_pos + static_cast<int64_t>(sizeof(T)) > m_capacity)
+                throw std::logic_error("Read from the file is out of its range: " + path);
+            T val;
+            read(utils::cast_to_uint8_t_data(&val), sizeof(T));
+            return val;
+        }
+
+        void write_next_data(ValueType val, const int32_t total_size_in_bytes) {
+            if constexpr(std::is_pointer_v<ValueType>) {
+                write_next_primitive(total_size_in_bytes);
+                write(val, total_size_in_bytes);
+            } else {
+                write_next_primitive(val);
+            }
+        }
+
+        /** Warning: do not write vector size */
+        template <typename T>
+        void write_node_vector(const std::vector<T>& vec) {
+            write(utils::cast_to_const_uint8_t_data(vec.data()), sizeof(T) * vec.size());
+        }
+
+        /** Warning: do not read vector size */
+        template <typename T>
+        void read_node_vector(std::vector<T>& vec) {
+            read(utils::cast_to_uint8_t_data(vec.data()), sizeof(T) * vec.size());
+        }
+
+        /** The missing pages of [POS, POS + SIZE) are read by the next submit_prefetches() */
+        void prefetch(const int64_t pos, const int64_t size = 1) {
+            cache.prefetch(pos, size);
+        }
+
+        void submit_prefetches() {
+            cache.load_prefetched(reader);
+        }
+
+        void keep_hot(const int64_t pos, const int64_t size) {
+            cache.keep_hot(pos, size);
+        }
+
+        /** The misses of the page cache go to the kernel page cache, its readahead follows the advice */
+        void advise(const io::Advice advice) {
+            handle.advise(advice);
+        }
+
+        /** The pages of the range are read by the explicit prefetches instead */
+        void advise(const int64_t, const int64_t, const io::Advice) const {}
+
+        int64_t get_pos() const { return m_pos; }
+        void set_pos(const int64_t pos) { m_pos = pos > 0 ? pos : 0; }
+        void set_file_pos_to_end() { m_pos = m_capacity; }
+
+        uint8_t read_byte() { return read_next_primitive<uint8_t>(); }
+        int16_t read_int16() { return read_next_primitive<int16_t>(); }
+        int32_t read_int32() { return read_next_primitive<int32_t>(); }
+        int64_t read_int64() { return read_next_primitive<int64_t>(); }
+
+        void shrink_to_fit() {
+            m_capacity = m_pos;
+            cache.discard_from(m_capacity);
+            handle.truncate(m_capacity);
+        }
+
+        bool is_empty() const {
+            return m_capacity == 0;
+        }
+
+    private:
+        void read(uint8_t* dst, const int64_t n) {
+            cache.read(m_pos, dst, n);
+            m_pos += n;
+        }
+
+        void write(const uint8_t* src, const int64_t n) {
+            cache.write(m_pos, src, n);
+            m_pos += n;
+            m_capacity = std::max(m_pos, m_capacity);
+        }
+    };
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BTREE_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define BTREE_HAS_IO_URING 0
+#endif
+
+namespace btree::io {
+    /** Read of SIZE bytes at POS of the file to DST */
+    struct ReadRequest {
+        int64_t pos;
+        uint8_t* dst;
+        int64_t size;
+    };
+
+#if BTREE_HAS_IO_URING
+    /**
+     * Minimal io_uring for batched reads, it's set up with the raw syscalls (no liburing dependency):
+     *  - read(...) fills the submission queue with READV requests, submits them with one io_uring_enter
+     *    and waits for all the completions, so the device sees the whole batch at once
+     *  - is_ready() is false if the kernel has no io_uring or it's forbidden (seccomp, sysctl), the caller falls back
+     */
+    class Uring final {
+        int ring_fd = -1;
+        uint32_t entries = 0;
+
+        void* sq_ring = nullptr;
+        size_t sq_ring_size = 0;
+        void* cq_ring = nullptr;
+        size_t cq_ring_size = 0;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqes_size = 0;
+
+        uint32_t* sq_tail = nullptr;
+        uint32_t* sq_mask = nullptr;
+        uint32_t* sq_array = nullptr;
+        uint32_t* cq_head = nullptr;
+        uint32_t* cq_tail = nullptr;
+        uint32_t* cq_mask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+    public:
+        explicit Uring(const uint32_t queue_depth) {
+            io_uring_params params{};
+            ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+            if (ring_fd < 0)
+                return;
+
+            entries = params.sq_entries;
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+            sq_ring = map(sq_ring_size, IORING_OFF_SQ_RING);
+            cq_ring = map(cq_ring_size, IORING_OFF_CQ_RING);
+            sqes = static_cast<io_uring_sqe*>(map(sqes_size, IORING_OFF_SQES));
+            if (!sq_ring || !cq_ring || !sqes) {
+                release();
+                return;
+            }
+
+            auto* sq = static_cast<uint8_t*>(sq_ring);
+            sq_tail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+            sq_mask = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+            auto* cq = static_cast<uint8_t*>(cq_ring);
+            cq_head = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+            cq_mask = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+
+        Uring(const Uring&) = delete;
+        Uring& operator=(const Uring&) = delete;
+
+        ~Uring() {
+            release();
+        }
+
+        bool is_ready() const {
+            return ring_fd >= 0;
+        }
+
+        /** Returns the number of bytes read by every request or -errno, the batch is split by the queue depth */
+        std::vector<int64_t> read(const int fd, const std::vector<ReadRequest>& requests) {
+            std::vector<int64_t> results(requests.size(), 0);
+            std::vector<iovec> iov(requests.size());
+            for (size_t begin = 0; begin < requests.size(); begin += entries) {
+                auto count = static_cast<uint32_t>(std::min<size_t>(entries, requests.size() - begin));
+
+                auto tail = *sq_tail;
+                for (uint32_t i = 0; i < count; ++i) {
+                    const auto& request = requests[begin + i];
+                    iov[begin + i] = iovec{ request.dst, static_cast<size_t>(request.size) };
+
+                    auto idx = (tail + i) & *sq_mask;
+                    auto& sqe = sqes[idx];
+                    sqe = io_uring_sqe{};
+                    sqe.opcode = IORING_OP_READV;
+                    sqe.fd = fd;
+                    sqe.addr = reinterpret_cast<uint64_t>(&iov[begin + i]);
+                    sqe.len = 1;
+                    sqe.off = static_cast<uint64_t>(request.pos);
+                    sqe.user_data = begin + i;
+                    sq_array[idx] = idx;
+                }
+                __atomic_store_n(sq_tail, tail + count, __ATOMIC_RELEASE);
+
+                uint32_t to_submit = count;
+                uint32_t completed = 0;
+                while (completed < count) {
+                    auto res = syscall(__NR_io_uring_enter, ring_fd, to_submit, count - completed,
+                                       IORING_ENTER_GETEVENTS, nullptr, 0);
+                    if (res < 0 && errno == EINTR)
+                        continue;
+                    if (res < 0) {
+                        // the ring isn't used after the failure: the lost completions can't be matched anymore
+                        const auto error = errno;
+                        release();
+                        for (size_t i = begin; i < requests.size(); ++i)
+                            results[i] = -error;
+                        return results;
+                    }
+                    to_submit -= std::min<uint32_t>(to_submit, static_cast<uint32_t>(res));
+                    auto head = *cq_head;
+                    auto cq_tail_value = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+                    for (; head != cq_tail_value; ++head, ++completed) {
+                        const auto& cqe = cqes[head & *cq_mask];
+                        results[cqe.user_data] = cqe.res;
+                    }
+                    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+                }
+            }
+            return results;
+        }
+
+    private:
+        void* map(const size_t size, const int64_t offset) const {
+            auto* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+            return ptr == MAP_FAILED ? nullptr : ptr;
+        }
+
+        void release() {
+            if (sqes)
+                munmap(sqes, sqes_size);
+            if (cq_ring)
+                munmap(cq_ring, cq_ring_size);
+            if (sq_ring)
+                munmap(sq_ring, sq_ring_size);
+            if (ring_fd >= 0)
+                close(ring_fd);
+            ring_fd = -1;
+            sqes = nullptr;
+            cq_ring = sq_ring = nullptr;
+        }
+    };
+#else
+    /** io_uring isn't available on the platform, the caller falls back */
+    class Uring final {
+    public:
+        explicit Uring(const uint32_t) {}
+        bool is_ready() const { return false; }
+        std::vector<int64_t> read(const int, const std::vector<ReadRequest>& requests) {
+            return std::vector<int64_t>(requests.size(), -1);
+        }
+    };
+#endif
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+/**
+ * Encoded (w)string|blob value of the volume with the value compression:
+ *     - CODEC                    |=> takes 1 byte  -> see io::Codec
+ *     ----------–----- CODEC = NONE:
+ *        - VALUES                |=> the raw bytes
+ *     ----------–----- CODEC = ZLIB:
+ *        - RAW_SIZE              |=> takes 4 bytes -> the size of the value in bytes
+ *        - ZLIB STREAM           |=> the compressed bytes
+ *     ----------–-----
+ */
+namespace btree::io {
+    enum class Codec : uint8_t {
+        NONE = 0,
+        /** zlib through Boost.Iostreams with the best speed level */
+        ZLIB = 1
+    };
+
+    /** Encodes the value to OUT, the value of the THRESHOLD size or bigger is compressed if it gets smaller */
+    inline void encode_value(const uint8_t* data, const int32_t size, const int32_t threshold, std::vector<uint8_t>& out) {
+        namespace bio = boost::iostreams;
+        out.clear();
+        if (size >= threshold) {
+            std::string compressed;
+            {
+                bio::filtering_ostream stream;
+                stream.push(bio::zlib_compressor(bio::zlib_params(bio::zlib::best_speed)));
+                stream.push(bio::back_inserter(compressed));
+                stream.write(reinterpret_cast<const char*>(data), size);
+            }
+            if (sizeof(size) + compressed.size() < static_cast<size_t>(size)) {
+                out.resize(1 + sizeof(size));
+                out[0] = static_cast<uint8_t>(Codec::ZLIB);
+                std::memcpy(out.data() + 1, &size, sizeof(size));
+                out.insert(out.end(), compressed.begin(), compressed.end());
+                return;
+            }
+        }
+        out.push_back(static_cast<uint8_t>(Codec::NONE));
+        out.insert(out.end(), data, data + size);
+    }
+
+    /**
+     * The value of the encoded one: NONE points into DATA, ZLIB is decompressed to the BUFFER of the caller.
+     * Returns { nullptr, -1 } for the unknown codec
+     */
+    inline std::pair<const uint8_t*, int32_t> decode_value(const uint8_t* data, const int32_t size, std::vector<uint8_t>& buffer) {
+        namespace bio = boost::iostreams;
+        if (size < 1 || data[0] > static_cast<uint8_t>(Codec::ZLIB))
+            return { nullptr, -1 };
+        if (data[0] == static_cast<uint8_t>(Codec::NONE))
+            return { data + 1, size - 1 };
+
+        int32_t raw_size = 0;
+        std::memcpy(&raw_size, data + 1, sizeof(raw_size));
+        buffer.resize(std::max<size_t>(raw_size, 1));
+
+        const auto header_size = 1 + static_cast<int32_t>(sizeof(raw_size));
+        bio::filtering_istream stream;
+        stream.push(bio::zlib_decompressor());
+        stream.push(bio::array_source(reinterpret_cast<const char*>(data) + header_size, size - header_size));
+        stream.read(reinterpret_cast<char*>(buffer.data()), raw_size);
+        if (stream.gcount() != raw_size)
+            return { nullptr, -1 };
+        return { buffer.data(), raw_size };
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+/**
+ * Value log structures (WiscKey-style, the files "<volume path>.vlog.<SEGMENT>" next to the volume file):
+ *
+ * - Segment header (8 bytes):
+ *     - MAGIC                    |=> takes 8 bytes
+ *
+ * - Record (M bytes), appended to the last segment only:
+ *     - KEY                      |=> takes KEY_SIZE bytes -> the liveness check looks for the KEY in the tree
+ *     - NUMBER_OF_ELEMENTS       |=> takes 4 bytes
+ *     - VALUES                   |=> takes (ELEMENT_SIZE * NUMBER_OF_ELEMENTS) bytes
+ *
+ * The record position is SEGMENT << SEGMENT_SHIFT | offset in the segment. The segment is sealed when it outgrows
+ * the segment size, the sealed segments are never modified: the garbage collection moves their live records
+ * to the last segment and removes the whole file.
+*/
+namespace btree {
+    template <typename K, typename V>
+    class ValueLog {
+        using ValueType = utils::conditional_t<std::is_arithmetic_v<V>, const V, const uint8_t*>;
+        using Segment = MappedFile<K, V>;
+
+        static constexpr int64_t MAGIC = 0x00474f4c56455254; // "TREVLOG"
+        static constexpr int64_t HEADER_SIZE = sizeof(MAGIC);
+        static constexpr int64_t SEGMENT_SHIFT = 40;
+
+        std::map<int64_t, std::unique_ptr<Segment>> segments;
+        const int64_t segment_size;
+        int64_t gc_due;
+        // the sealed segments in the order of the last garbage collection check
+        std::deque<int64_t> gc_queue;
+    public:
+        const std::string path;
+
+        ValueLog(const std::string& path, const int64_t segment_size);
+
+        /** Appends the record to the last segment, returns the record position */
+        int64_t append(const K key, ValueType value, const int32_t size);
+        /** The value of the record at POS, it's valid until the last segment grows */
+        std::pair<ValueType, int32_t> read(const int64_t pos);
+        /** Appends the copy of the record at POS from the sealed segment, returns the new position */
+        int64_t move(const int64_t pos);
+
+        /** Calls fn(key, pos, size) for every record of the SEGMENT in the order of positions */
+        template <typename Fn>
+        void for_each_record(const int64_t segment, Fn&& fn);
+        int64_t size_in_bytes(const int64_t segment) const;
+        /** The sealed segments in the order of age */
+        std::vector<int64_t> sealed_segments() const;
+        void remove_segment(const int64_t segment);
+        /** Removes all the records, the values of the new volume start from the empty log */
+        void clear();
+
+        /** A segment was sealed since the last next_gc_segment(), one segment is collected per sealed one */
+        bool is_gc_due() const;
+        /** The sealed segment that wasn't checked for the longest time, the new sealed segments are checked last */
+        int64_t next_gc_segment();
+    private:
+        Segment& open_segment(const int64_t segment);
+        std::string segment_path(const int64_t segment) const;
+        int64_t last_segment() const;
+    };
+}
+
+#include "value_log_impl.h"
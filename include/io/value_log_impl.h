@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+
+#include "utils/error.h"
+
+namespace btree {
+    template <typename K, typename V>
+    ValueLog<K, V>::ValueLog(const std::string& path, const int64_t segment_size) :
+        segment_size(segment_size), gc_due(0), path(path)
+    {
+        const auto file_path = std::filesystem::path(path);
+        const auto prefix = file_path.filename().string() + ".";
+        auto dir = file_path.parent_path().empty() ? std::filesystem::path(".") : file_path.parent_path();
+        std::error_code ec;
+        for (const auto& item: std::filesystem::directory_iterator(dir, ec)) {
+            const auto name = item.path().filename().string();
+            const auto suffix = name.substr(std::min(prefix.size(), name.size()));
+            if (name.compare(0, prefix.size(), prefix) != 0 || suffix.empty() ||
+                suffix.find_first_not_of("0123456789") != std::string::npos)
+                continue;
+            open_segment(std::stoll(suffix));
+        }
+        if (segments.empty())
+            open_segment(0);
+        const auto sealed = sealed_segments();
+        gc_queue.assign(sealed.begin(), sealed.end());
+    }
+
+    template <typename K, typename V>
+    int64_t ValueLog<K, V>::append(const K key, ValueType value, const int32_t size) {
+        auto* file = segments.rbegin()->second.get();
+        file->set_file_pos_to_end();
+        const int64_t record_size = sizeof(K) + sizeof(int32_t) + size;
+        if (file->get_pos() > HEADER_SIZE && file->get_pos() + record_size > segment_size) {
+            gc_queue.push_back(last_segment());
+            file = &open_segment(last_segment() + 1);
+            ++gc_due;
+        }
+
+        const auto pos = (last_segment() << SEGMENT_SHIFT) | file->get_pos();
+        file->write_next_primitive(key);
+        file->write_next_data(value, size);
+        return pos;
+    }
+
+    template <typename K, typename V>
+    std::pair<typename ValueLog<K, V>::ValueType, int32_t> ValueLog<K, V>::read(const int64_t pos) {
+        auto it = segments.find(pos >> SEGMENT_SHIFT);
+        validate(it != segments.end(), error_msg::wrong_value_log_msg, segment_path(pos >> SEGMENT_SHIFT));
+
+        it->second->set_pos((pos & ((int64_t(1) << SEGMENT_SHIFT) - 1)) + sizeof(K));
+        return it->second->template read_next_data<ValueType>();
+    }
+
+    template <typename K, typename V>
+    int64_t ValueLog<K, V>::move(const int64_t pos) {
+        auto& file = *segments.at(pos >> SEGMENT_SHIFT);
+        file.set_pos(pos & ((int64_t(1) << SEGMENT_SHIFT) - 1));
+        const K key = file.template read_next_primitive<K>();
+        auto [value, size] = file.template read_next_data<ValueType>();
+        // the sealed segment isn't remapped by the append, the value stays valid
+        return append(key, value, size);
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    void ValueLog<K, V>::for_each_record(const int64_t segment, Fn&& fn) {
+        auto& file = *segments.at(segment);
+        file.set_file_pos_to_end();
+        const auto end = file.get_pos();
+        for (int64_t pos = HEADER_SIZE; pos < end; ) {
+            file.set_pos(pos);
+            const K key = file.template read_next_primitive<K>();
+            const auto size = file.read_int32();
+            fn(key, (segment << SEGMENT_SHIFT) | pos, size);
+            pos += sizeof(K) + sizeof(int32_t) + size;
+        }
+    }
+
+    template <typename K, typename V>
+    int64_t ValueLog<K, V>::size_in_bytes(const int64_t segment) const {
+        auto& file = *segments.at(segment);
+        file.set_file_pos_to_end();
+        return file.get_pos();
+    }
+
+    template <typename K, typename V>
+    std::vector<int64_t> ValueLog<K, V>::sealed_segments() const {
+        std::vector<int64_t> sealed;
+        for (const auto& [segment, file]: segments) {
+            if (segment != last_segment())
+                sealed.push_back(segment);
+        }
+        return sealed;
+    }
+
+    template <typename K, typename V>
+    void ValueLog<K, V>::remove_segment(const int64_t segment) {
+        if (segment == last_segment())
+            return;
+
+        segments.erase(segment);
+        gc_queue.erase(std::remove(gc_queue.begin(), gc_queue.end(), segment), gc_queue.end());
+        std::error_code ec;
+        std::filesystem::remove(segment_path(segment), ec);
+    }
+
+    template <typename K, typename V>
+    void ValueLog<K, V>::clear() {
+        std::error_code ec;
+        for (auto& [segment, file]: segments) {
+            file.reset();
+            std::filesystem::remove(segment_path(segment), ec);
+        }
+        segments.clear();
+        open_segment(0);
+        gc_queue.clear();
+        gc_due = 0;
+    }
+
+    template <typename K, typename V>
+    bool ValueLog<K, V>::is_gc_due() const {
+        return gc_due > 0;
+    }
+
+    template <typename K, typename V>
+    int64_t ValueLog<K, V>::next_gc_segment() {
+        gc_due = std::max<int64_t>(gc_due - 1, 0);
+        if (gc_queue.empty())
+            return -1;
+
+        // the segment goes to the back of the queue if it isn't removed
+        auto segment = gc_queue.front();
+        gc_queue.pop_front();
+        gc_queue.push_back(segment);
+        return segment;
+    }
+
+    template <typename K, typename V>
+    typename ValueLog<K, V>::Segment& ValueLog<K, V>::open_segment(const int64_t segment) {
+        auto& file = segments[segment];
+        file = std::make_unique<Segment>(segment_path(segment), 0);
+        if (file->is_empty()) {
+            file->write_next_primitive(MAGIC);
+            return *file;
+        }
+        file->set_pos(0);
+        validate(file->read_int64() == MAGIC, error_msg::wrong_value_log_msg, file->path);
+        return *file;
+    }
+
+    template <typename K, typename V>
+    std::string ValueLog<K, V>::segment_path(const int64_t segment) const {
+        return path + "." + std::to_string(segment);
+    }
+
+    template <typename K, typename V>
+    int64_t ValueLog<K, V>::last_segment() const {
+        return segments.rbegin()->first;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <variant>
+
+#include "backend.h"
+#include "mapped_file.h"
+#include "positional_file.h"
+
+namespace btree {
+    /** The volume file of IOManager with the backend chosen when the volume is opened (see io::Backend) */
+    template <typename K, typename V>
+    class VolumeFile {
+        using ValueType = utils::conditional_t<std::is_arithmetic_v<V>, const V, const uint8_t*>;
+
+        std::variant<MappedFile<K, V>, PositionalFile<K, V>> file;
+    public:
+        const std::string path;
+
+        VolumeFile(const std::string& path, const io::FileOptions& options) : file(make(path, options)), path(path) {
+            if (options.advice != io::Advice::NORMAL)
+                advise(options.advice);
+        }
+
+        template <typename ValueType>
+        std::pair<ValueType, int32_t> read_next_data() {
+            return std::visit([](auto& f) { return f.template read_next_data<ValueType>(); }, file);
+        }
+
+        template <typename T>
+        void write_next_primitive(const T val) {
+            std::visit([val](auto& f) { f.write_next_primitive(val); }, file);
+        }
+
+        template <typename T>
+        T read_next_primitive() {
+            return std::visit([](auto& f) { return f.template read_next_primitive<T>(); }, file);
+        }
+
+        void write_next_data(ValueType val, const int32_t total_size_in_bytes) {
+            std::visit([val, total_size_in_bytes](auto& f) { f.write_next_data(val, total_size_in_bytes); }, file);
+        }
+
+        template <typename T>
+        void write_node_vector(const std::vector<T>& vec) {
+            std::visit([&vec](auto& f) { f.write_node_vector(vec); }, file);
+        }
+
+        template <typename T>
+        void read_node_vector(std::vector<T>& vec) {
+            std::visit([&vec](auto& f) { f.read_node_vector(vec); }, file);
+        }
+
+        void prefetch(const int64_t pos, const int64_t size = 1) {
+            std::visit([pos, size](auto& f) { f.prefetch(pos, size); }, file);
+        }
+
+        void submit_prefetches() {
+            std::visit([](auto& f) { f.submit_prefetches(); }, file);
+        }
+
+        void advise(const io::Advice advice) {
+            std::visit([advice](auto& f) { f.advise(advice); }, file);
+        }
+
+        void advise(const int64_t pos, const int64_t size, const io::Advice advice) const {
+            std::visit([pos, size, advice](const auto& f) { f.advise(pos, size, advice); }, file);
+        }
+
+        /** The range holds the internal node: the explicit backend evicts its pages last */
+        void keep_hot(const int64_t pos, const int64_t size) {
+            std::visit([pos, size](auto& f) { f.keep_hot(pos, size); }, file);
+        }
+
+        int64_t get_pos() const {
+            return std::visit([](const auto& f) { return f.get_pos(); }, file);
+        }
+
+        void set_pos(const int64_t pos) {
+            std::visit([pos](auto& f) { f.set_pos(pos); }, file);
+        }
+
+        void set_file_pos_to_end() {
+            std::visit([](auto& f) { f.set_file_pos_to_end(); }, file);
+        }
+
+        uint8_t read_byte() { return read_next_primitive<uint8_t>(); }
+        int16_t read_int16() { return read_next_primitive<int16_t>(); }
+        int32_t read_int32() { return read_next_primitive<int32_t>(); }
+        int64_t read_int64() { return read_next_primitive<int64_t>(); }
+
+        void shrink_to_fit() {
+            std::visit([](auto& f) { f.shrink_to_fit(); }, file);
+        }
+
+        bool is_empty() const {
+            return std::visit([](const auto& f) { return f.is_empty(); }, file);
+        }
+
+    private:
+        static std::variant<MappedFile<K, V>, PositionalFile<K, V>> make(const std::string& path,
+                                                                          const io::FileOptions& options)
+        {
+            if (options.backend != io::Backend::MMAP)
+                return std::variant<MappedFile<K, V>, PositionalFile<K, V>>(
+                        std::in_place_type<PositionalFile<K, V>>, path, options);
+            return std::variant<MappedFile<K, V>, PositionalFile<K, V>>(std::in_place_type<MappedFile<K, V>>, path, 0);
+        }
+    };
+}
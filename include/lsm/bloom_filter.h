@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace btree::lsm {
+    /** Bloom filter with double hashing: bit_i = (h1 + i * h2) mod NUM_BITS */
+    class BloomFilter {
+        std::vector<uint64_t> m_words;
+        uint64_t m_num_bits;
+        uint8_t m_hash_count;
+
+        static constexpr int32_t bits_per_key = 10;
+        static constexpr uint8_t max_hash_count = 30;
+
+        static uint64_t mix(uint64_t h) {
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+            return h ^ (h >> 31);
+        }
+    public:
+        explicit BloomFilter() : m_num_bits(0), m_hash_count(0) {}
+
+        explicit BloomFilter(const int64_t keys_count) :
+            m_words((std::max<int64_t>(keys_count, 1) * bits_per_key + 63) / 64, 0),
+            m_num_bits(m_words.size() * 64),
+            // k = ln2 * bits_per_key is optimal for the false positive rate (~1% for 10 bits per key)
+            m_hash_count(static_cast<uint8_t>(bits_per_key * 69 / 100)) {}
+
+        BloomFilter(std::vector<uint64_t>&& words, const uint8_t hash_count) :
+            m_words(std::move(words)),
+            m_num_bits(m_words.size() * 64),
+            m_hash_count(std::min(hash_count, max_hash_count)) {}
+
+        void add(const int64_t key) {
+            auto h1 = mix(static_cast<uint64_t>(key));
+            auto h2 = (h1 >> 32) | 1;
+            for (uint8_t i = 0; i < m_hash_count; ++i) {
+                auto bit = (h1 + i * h2) % m_num_bits;
+                m_words[bit / 64] |= (1ULL << (bit % 64));
+            }
+        }
+
+        bool may_contain(const int64_t key) const {
+            if (m_num_bits == 0)
+                return true;
+
+            auto h1 = mix(static_cast<uint64_t>(key));
+            auto h2 = (h1 >> 32) | 1;
+            for (uint8_t i = 0; i < m_hash_count; ++i) {
+                auto bit = (h1 + i * h2) % m_num_bits;
+                if ((m_words[bit / 64] & (1ULL << (bit % 64))) == 0)
+                    return false;
+            }
+            return true;
+        }
+
+        const std::vector<uint64_t>& words() const { return m_words; }
+
+        uint8_t hash_count() const { return m_hash_count; }
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "memtable.h"
+
+namespace btree::lsm {
+    /** Forward iterator over the sorted entries of one LSM level (memtable or sorted run) */
+    template <typename K, typename V>
+    class Cursor {
+    public:
+        using EntryT = entry::Entry<K, V>;
+
+        virtual ~Cursor() = default;
+
+        virtual bool is_valid() const = 0;
+        virtual K key() const = 0;
+        /** The removed KEY is returned as an entry with zero size */
+        virtual EntryT entry() = 0;
+        virtual void next() = 0;
+    };
+
+    template <typename K, typename V>
+    class MemTableCursor final : public Cursor<K, V> {
+        using EntryT = typename Cursor<K, V>::EntryT;
+        using ConstIterator = typename MemTable<K, V>::ConstIterator;
+
+        ConstIterator it;
+        const ConstIterator end;
+    public:
+        MemTableCursor(const MemTable<K, V>& memtable, const K from) :
+            it(memtable.lower_bound(from)), end(memtable.end()) {}
+
+        bool is_valid() const override { return it != end; }
+        K key() const override { return it->first; }
+        EntryT entry() override { return MemTable<K, V>::to_entry(it->first, it->second); }
+        void next() override { ++it; }
+    };
+
+    template <typename K, typename V>
+    using Cursors = std::vector<std::unique_ptr<Cursor<K, V>>>;
+
+    /**
+     * K-way merge of the cursors ordered from the newest level to the oldest one:
+     *  - calls fn(entry) for the newest entry of every KEY in the ascending order of keys
+     *  - the older entries with the same KEY are shadowed
+     *  - stops when fn returns false
+     */
+    template <typename K, typename V, typename Fn>
+    void merge(Cursors<K, V>& cursors, Fn&& fn) {
+        const auto n = static_cast<int32_t>(cursors.size());
+        while (true) {
+            int32_t newest = -1;
+            K min_key = K();
+            for (int32_t i = 0; i < n; ++i) {
+                if (cursors[i]->is_valid() && (newest == -1 || cursors[i]->key() < min_key)) {
+                    newest = i;
+                    min_key = cursors[i]->key();
+                }
+            }
+            if (newest == -1)
+                return;
+
+            bool proceed = fn(cursors[newest]->entry());
+            for (auto& cursor: cursors) {
+                if (cursor->is_valid() && cursor->key() == min_key)
+                    cursor->next();
+            }
+            if (!proceed)
+                return;
+        }
+    }
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+#include <limits>
+#include <thread>
+
+#include "sorted_run.h"
+
+/**
+ * LSM volume structures:
+ *
+ * - Manifest (the volume file, it's rewritten atomically after every flush or compaction):
+ *     - KEY_SIZE                 |=> takes 1 byte
+ *     - VALUE_TYPE               |=> takes 1 byte
+ *     - ELEMENT_SIZE             |=> takes 1 byte
+ *     - NEXT_RUN_ID              |=> takes 8 bytes
+ *     - RUN_COUNT                |=> takes 4 bytes
+ *     - RUN_ID                   |=> takes 8 bytes for every sorted run, from the newest run to the oldest one
+ *
+ * - Sorted run (see sorted_run.h) is stored in the "<volume path>.<RUN_ID>.run" file
+ *
+ * Writes go to the memtable, the full memtable is written sequentially to a new sorted run
+ * (together with the newest run if it's small, so the volumes closed after a few modifications don't pile up tiny runs).
+ * The background thread merges the runs (size-tiered compaction), the owner thread installs the merged run
+ * on the next modification, so the values returned by get(...) stay valid until the next modification.
+ * The error of the failed compaction is thrown by the next modification, the runs are kept as they were.
+ * The memtable isn't logged: the unflushed modifications are lost if the process doesn't close the volume.
+*/
+namespace btree::volume {
+    template <typename K, typename V>
+    class Volume<K, V, engine::LSMEngine> final {
+        using EntryT = entry::Entry<K, V>;
+        using MemTableT = lsm::MemTable<K, V>;
+        using Run = lsm::SortedRun<K, V>;
+
+        struct CompactionTask {
+            std::vector<int64_t> run_ids; // from the newest run to the oldest one
+            int64_t output_run_id;
+            bool drop_removed;
+            bool is_done;
+            std::exception_ptr error;
+        };
+
+        static constexpr int64_t INVALID_RUN_ID = -1;
+        // the next older run joins the compaction if it isn't bigger than SIZE_RATIO * (size of the newer runs)
+        static constexpr int64_t SIZE_RATIO = 2;
+        // the newest run is merged with the flushed memtable if it's smaller than memtable_size_in_bytes / SMALL_RUN_RATIO
+        static constexpr int64_t SMALL_RUN_RATIO = 16;
+
+        const size_t memtable_size_in_bytes;
+        const size_t max_sorted_runs;
+        const bool read_only;
+        MemTableT memtable;
+        std::vector<std::unique_ptr<Run>> runs; // from the newest run to the oldest one
+        int64_t next_run_id;
+        bool compaction_is_scheduled;
+
+        std::mutex compaction_mutex;
+        std::condition_variable compaction_cv;
+        std::optional<CompactionTask> pending_task;
+        std::optional<CompactionTask> finished_task;
+        bool stopped;
+        std::thread compaction_thread;
+    public:
+        using ValueType = typename BTree<K, V>::ValueType;
+        /** The size of the manifest without the list of runs */
+        static constexpr int32_t MANIFEST_HEADER_SIZE = 3 + sizeof(int64_t) + sizeof(int32_t);
+        const std::string path;
+
+        explicit Volume(const std::string& path, const int16_t order, const VolumeOptions& options = VolumeOptions());
+        ~Volume();
+
+        bool exist(const K key);
+        void set(const K key, const ValueType value);
+        void set(const K key, const V& value, const int32_t size);
+        std::optional<V> get(const K key);
+        /** The runs are searched key by key: the bloom filters skip most of them */
+        std::vector<std::optional<utils::owned_value_t<V>>> multi_get(const std::vector<K>& keys);
+        bool remove(const K key);
+
+        template <typename Fn>
+        void scan(const K from, const K to, Fn&& fn);
+
+    private:
+        std::optional<EntryT> find_entry(const K key);
+        void put(const EntryT& e);
+
+        std::string run_path(const int64_t run_id) const;
+        void read_manifest();
+        void write_manifest();
+
+        void flush_memtable();
+        void maybe_schedule_compaction();
+        void install_compaction();
+        void run_compaction_loop();
+        void compact(CompactionTask& task);
+    };
+
+    template <typename K, typename V>
+    Volume<K, V, engine::LSMEngine>::Volume(const std::string& path, const int16_t order, const VolumeOptions& options) :
+        memtable_size_in_bytes(options.memtable_size_in_bytes),
+        max_sorted_runs(std::max(options.max_sorted_runs, 1)),
+        read_only(options.read_only),
+        next_run_id(0),
+        compaction_is_scheduled(false),
+        stopped(false),
+        path(path)
+    {
+        read_manifest();
+        compaction_thread = std::thread([this] { run_compaction_loop(); });
+        if (!read_only)
+            maybe_schedule_compaction();
+    }
+
+    template <typename K, typename V>
+    Volume<K, V, engine::LSMEngine>::~Volume() {
+        {
+            std::scoped_lock lock(compaction_mutex);
+            stopped = true;
+        }
+        compaction_cv.notify_one();
+        compaction_thread.join();
+
+        // the destructor doesn't throw: the failed flush loses the memtable, as the process that didn't close the volume
+        try {
+            install_compaction();
+        } catch (...) {}
+        try {
+            flush_memtable();
+        } catch (...) {}
+    }
+
+    template <typename K, typename V>
+    bool Volume<K, V, engine::LSMEngine>::exist(const K key) {
+        auto e = find_entry(key);
+        return e.has_value() && (e->size_in_bytes != 0);
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::set(const K key, const ValueType value) {
+        put(EntryT{ key, value });
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::set(const K key, const V& value, const int32_t size) {
+        if (size != 0)
+            put(EntryT{ key, value, size });
+    }
+
+    template <typename K, typename V>
+    std::optional<V> Volume<K, V, engine::LSMEngine>::get(const K key) {
+        auto e = find_entry(key);
+        return e.has_value() ? e->value() : std::nullopt;
+    }
+
+    template <typename K, typename V>
+    std::vector<std::optional<utils::owned_value_t<V>>> Volume<K, V, engine::LSMEngine>::multi_get(const std::vector<K>& keys) {
+        std::vector<std::optional<utils::owned_value_t<V>>> values;
+        values.reserve(keys.size());
+        for (const auto key: keys) {
+            auto e = find_entry(key);
+            values.push_back(e.has_value() ? e->owned_value() : std::nullopt);
+        }
+        return values;
+    }
+
+    template <typename K, typename V>
+    bool Volume<K, V, engine::LSMEngine>::remove(const K key) {
+        validate(!read_only, error_msg::read_only_volume_msg, path);
+        install_compaction();
+        if (!exist(key))
+            return false;
+
+        memtable.remove(key);
+        if (memtable.size_in_bytes() >= memtable_size_in_bytes)
+            flush_memtable();
+        return true;
+    }
+
+    template <typename K, typename V>
+    template <typename Fn>
+    void Volume<K, V, engine::LSMEngine>::scan(const K from, const K to, Fn&& fn) {
+        if (from > to)
+            return;
+
+        lsm::Cursors<K, V> cursors;
+        cursors.push_back(std::make_unique<lsm::MemTableCursor<K, V>>(memtable, from));
+        for (auto& run: runs)
+            cursors.push_back(run->cursor(from));
+
+        lsm::merge(cursors, [&fn, to](const EntryT& e) {
+            if (e.key > to)
+                return false;
+            auto value = e.value();
+            return !value || utils::invoke_value_and_proceed(fn, e.key, *value, e.size_in_bytes);
+        });
+    }
+
+    template <typename K, typename V>
+    std::optional<typename Volume<K, V, engine::LSMEngine>::EntryT>
+    Volume<K, V, engine::LSMEngine>::find_entry(const K key) {
+        if (auto* record = memtable.find(key))
+            return MemTableT::to_entry(key, *record);
+
+        for (auto& run: runs) {
+            if (auto e = run->find(key))
+                return e;
+        }
+        return std::nullopt;
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::put(const EntryT& e) {
+        validate(!read_only, error_msg::read_only_volume_msg, path);
+        install_compaction();
+        memtable.set(e);
+        if (memtable.size_in_bytes() >= memtable_size_in_bytes)
+            flush_memtable();
+    }
+
+    template <typename K, typename V>
+    std::string Volume<K, V, engine::LSMEngine>::run_path(const int64_t run_id) const {
+        return path + "." + std::to_string(run_id) + ".run";
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::read_manifest() {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        // the new volume has the empty manifest, as the new B-tree volume has the empty file
+        if (ec && !read_only)
+            std::ofstream(path, std::ios::binary);
+        if (size == 0 || ec)
+            return;
+
+        std::ifstream in(path, std::ios::binary);
+        auto read = [&in](auto& val) { in.read(reinterpret_cast<char*>(&val), sizeof(val)); };
+
+        uint8_t key_size = 0, value_type_code = 0, element_size = 0;
+        read(key_size);
+        read(value_type_code);
+        read(element_size);
+        validate(key_size == sizeof(K), error_msg::wrong_key_size_msg, path);
+        validate(value_type_code == get_value_type_code<V>(), error_msg::wrong_value_type_msg, path);
+        validate(element_size == get_element_size<V>(), error_msg::wrong_element_size_msg, path);
+
+        int32_t run_count = 0;
+        read(next_run_id);
+        read(run_count);
+        for (int32_t i = 0; i < run_count; ++i) {
+            int64_t run_id = INVALID_RUN_ID;
+            read(run_id);
+            runs.push_back(std::make_unique<Run>(run_path(run_id), run_id));
+        }
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::write_manifest() {
+        const auto& tmp_path = path + ".tmp";
+        {
+            std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+            auto write = [&out](const auto val) { out.write(reinterpret_cast<const char*>(&val), sizeof(val)); };
+
+            write(static_cast<uint8_t>(sizeof(K)));
+            write(get_value_type_code<V>());
+            write(get_element_size<V>());
+            write(next_run_id);
+            write(static_cast<int32_t>(runs.size()));
+            for (const auto& run: runs)
+                write(run->id);
+        }
+        // the manifest is replaced at once, so the crash leaves either the old list of runs or the new one
+        std::filesystem::rename(tmp_path, path);
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::flush_memtable() {
+        if (memtable.empty())
+            return;
+
+        // the runs of the scheduled compaction stay as they are
+        const bool merge_newest_run = !compaction_is_scheduled && !runs.empty()
+            && runs[0]->size_in_bytes() * SMALL_RUN_RATIO < static_cast<int64_t>(memtable_size_in_bytes);
+        // nothing is shadowed by the removed keys if there are no older runs
+        const bool drop_removed = runs.size() == (merge_newest_run ? 1 : 0);
+        const auto run_id = next_run_id++;
+        const auto& new_run_path = run_path(run_id);
+        std::filesystem::remove(new_run_path);
+
+        int64_t count = 0;
+        {
+            lsm::Cursors<K, V> cursors;
+            cursors.push_back(std::make_unique<lsm::MemTableCursor<K, V>>(memtable, std::numeric_limits<K>::min()));
+            if (merge_newest_run)
+                cursors.push_back(runs[0]->cursor(std::numeric_limits<K>::min()));
+
+            typename Run::Builder builder(new_run_path);
+            lsm::merge(cursors, [drop_removed, &builder](const EntryT& e) {
+                if (!(drop_removed && e.size_in_bytes == 0))
+                    builder.add(e);
+                return true;
+            });
+            builder.finish();
+            count = builder.count();
+        }
+        memtable.clear();
+
+        auto merged_run_id = INVALID_RUN_ID;
+        if (merge_newest_run) {
+            merged_run_id = runs[0]->id;
+            runs.erase(runs.begin());
+        }
+        if (count > 0)
+            runs.insert(runs.begin(), std::make_unique<Run>(new_run_path, run_id));
+        else
+            std::filesystem::remove(new_run_path);
+
+        write_manifest();
+        if (merged_run_id != INVALID_RUN_ID)
+            std::filesystem::remove(run_path(merged_run_id));
+        maybe_schedule_compaction();
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::maybe_schedule_compaction() {
+        if (compaction_is_scheduled || runs.size() <= max_sorted_runs)
+            return;
+
+        // Size-tiered window: the newest runs together with the older runs of the comparable size
+        size_t window = 1;
+        int64_t window_size = runs[0]->size_in_bytes();
+        while (window < runs.size() && runs[window]->size_in_bytes() <= SIZE_RATIO * window_size) {
+            window_size += runs[window]->size_in_bytes();
+            ++window;
+        }
+        if (window < 2)
+            window = runs.size();
+
+        CompactionTask task { {}, next_run_id++, window == runs.size(), false, nullptr };
+        for (size_t i = 0; i < window; ++i)
+            task.run_ids.push_back(runs[i]->id);
+
+        {
+            std::scoped_lock lock(compaction_mutex);
+            if (stopped)
+                return;
+            pending_task = std::move(task);
+        }
+        compaction_is_scheduled = true;
+        compaction_cv.notify_one();
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::install_compaction() {
+        std::optional<CompactionTask> task;
+        {
+            std::scoped_lock lock(compaction_mutex);
+            task.swap(finished_task);
+        }
+        if (!task.has_value())
+            return;
+
+        compaction_is_scheduled = false;
+        if (task->is_done) {
+            // The merged runs are still adjacent: the flush adds the newest runs only
+            auto first = std::find_if(runs.begin(), runs.end(), [&task](const auto& run) {
+                return run->id == task->run_ids.front();
+            });
+            auto pos = runs.erase(first, first + static_cast<int64_t>(task->run_ids.size()));
+            if (task->output_run_id != INVALID_RUN_ID)
+                runs.insert(pos, std::make_unique<Run>(run_path(task->output_run_id), task->output_run_id));
+
+            write_manifest();
+            for (auto run_id: task->run_ids)
+                std::filesystem::remove(run_path(run_id));
+        }
+        // the runs are kept as they were, the next flush schedules the compaction again
+        if (task->error)
+            std::rethrow_exception(task->error);
+        maybe_schedule_compaction();
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::run_compaction_loop() {
+        while (true) {
+            CompactionTask task;
+            {
+                std::unique_lock lock(compaction_mutex);
+                compaction_cv.wait(lock, [this] { return stopped || pending_task.has_value(); });
+                if (stopped)
+                    return;
+                task = std::move(*pending_task);
+                pending_task.reset();
+            }
+
+            compact(task);
+
+            std::scoped_lock lock(compaction_mutex);
+            finished_task = std::move(task);
+        }
+    }
+
+    template <typename K, typename V>
+    void Volume<K, V, engine::LSMEngine>::compact(CompactionTask& task) {
+        const auto& output_path = run_path(task.output_run_id);
+        try {
+            // the thread reads the runs with its own mapped files, the owner thread keeps using the old ones
+            std::vector<std::unique_ptr<Run>> inputs;
+            lsm::Cursors<K, V> cursors;
+            for (auto run_id: task.run_ids) {
+                inputs.push_back(std::make_unique<Run>(run_path(run_id), run_id));
+                inputs.back()->advise(io::Advice::SEQUENTIAL);
+                cursors.push_back(inputs.back()->cursor(std::numeric_limits<K>::min()));
+            }
+
+            std::filesystem::remove(output_path);
+            int64_t count = 0;
+            {
+                typename Run::Builder builder(output_path);
+                lsm::merge(cursors, [&task, &builder](const EntryT& e) {
+                    if (!(task.drop_removed && e.size_in_bytes == 0))
+                        builder.add(e);
+                    return true;
+                });
+                builder.finish();
+                count = builder.count();
+            }
+
+            if (count == 0) {
+                std::filesystem::remove(output_path);
+                task.output_run_id = INVALID_RUN_ID;
+            }
+            task.is_done = true;
+        } catch (...) {
+            // the error is rethrown by the owner thread on the next modification
+            task.error = std::current_exception();
+            std::error_code ec;
+            std::filesystem::remove(output_path, ec);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstring>
+
+#include "btree_impl/entry.h"
+
+namespace btree::lsm {
+    /**
+     * Sorted in-memory buffer of the latest modifications: { KEY -> value bytes | removal mark }.
+     * The entries returned by the memtable point to its own memory, they are valid until the next modification.
+     */
+    template <typename K, typename V>
+    class MemTable {
+    public:
+        using EntryT = entry::Entry<K, V>;
+
+        struct Record {
+            std::vector<uint8_t> data;
+            bool is_removed = false;
+            int64_t expires_at = 0;
+        };
+        using ConstIterator = typename std::map<K, Record>::const_iterator;
+    private:
+        // approximate per-record overhead of the std::map node
+        static constexpr size_t record_overhead_in_bytes = 64;
+
+        std::map<K, Record> records;
+        size_t m_size_in_bytes = 0;
+    public:
+        void set(const EntryT& e) {
+            Record r;
+            if constexpr(std::is_arithmetic_v<V>) {
+                auto* data = reinterpret_cast<const uint8_t*>(&e.data);
+                r.data.assign(data, data + sizeof(V));
+            } else {
+                r.data.assign(e.data, e.data + e.size_in_bytes);
+            }
+            r.expires_at = e.expires_at;
+            put(e.key, std::move(r));
+        }
+
+        void remove(const K key) {
+            Record r;
+            r.is_removed = true;
+            put(key, std::move(r));
+        }
+
+        /** Returns nullptr if the memtable doesn't know anything about the KEY */
+        const Record* find(const K key) const {
+            auto it = records.find(key);
+            return (it != records.end()) ? &it->second : nullptr;
+        }
+
+        /** Converts the record to the entry, the removed record becomes an entry with zero size */
+        static EntryT to_entry(const K key, const Record& r) {
+            using ValueType = typename EntryT::ValueType;
+            if (r.is_removed)
+                return EntryT(key, ValueType(), 0);
+
+            if constexpr(std::is_arithmetic_v<V>) {
+                V value;
+                std::memcpy(&value, r.data.data(), sizeof(V));
+                return EntryT(key, value, sizeof(V), r.expires_at);
+            } else {
+                return EntryT(key, r.data.data(), static_cast<int32_t>(r.data.size()), r.expires_at);
+            }
+        }
+
+        ConstIterator begin() const { return records.begin(); }
+        ConstIterator end() const { return records.end(); }
+        ConstIterator lower_bound(const K key) const { return records.lower_bound(key); }
+
+        bool empty() const { return records.empty(); }
+        size_t size() const { return records.size(); }
+        size_t size_in_bytes() const { return m_size_in_bytes; }
+
+        void clear() {
+            records.clear();
+            m_size_in_bytes = 0;
+        }
+
+    private:
+        void put(const K key, Record&& r) {
+            auto [it, inserted] = records.try_emplace(key);
+            if (inserted)
+                m_size_in_bytes += sizeof(K) + record_overhead_in_bytes;
+            m_size_in_bytes -= it->second.data.size();
+            m_size_in_bytes += r.data.size();
+            it->second = std::move(r);
+        }
+    };
+}
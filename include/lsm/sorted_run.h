@@ -0,0 +1,92 @@
+#pragma once
+
+#include <optional>
+
+#include "io/mapped_file.h"
+#include "bloom_filter.h"
+#include "cursor.h"
+
+/**
+ * Sorted run structures (an immutable file written sequentially once):
+ *
+ * - Header (24 bytes):
+ *     - ENTRY_COUNT              |=> takes 8 bytes
+ *     - INDEX_POS                |=> takes 8 bytes -> pos of the entry index in file
+ *     - BLOOM_POS                |=> takes 8 bytes -> pos of the bloom filter in file
+ *
+ * - Entry (M bytes), entries are sorted by KEY:
+ *     - KEY                      |=> takes KEY_SIZE bytes
+ *     - FLAG                     |=> takes 1 byte -> 0 for the value, 1 for the removed KEY (no VALUE follows)
+ *     ----------–-----
+ *        - VALUE                 |=> takes ELEMENT_SIZE bytes for primitive VALUE_TYPE
+ *     or
+ *        - NUMBER_OF_ELEMENTS    |=> takes 4 bytes
+ *        - VALUES                |=> takes (ELEMENT_SIZE * NUMBER_OF_ELEMENTS) bytes
+ *     ----------–-----
+ *
+ * - Index (ENTRY_COUNT * 8 bytes):
+ *     - ENTRY_POS                |=> takes 8 bytes for every entry -> for the binary search
+ *
+ * - Bloom filter:
+ *     - WORD_COUNT               |=> takes 8 bytes
+ *     - HASH_COUNT               |=> takes 1 byte
+ *     - WORDS                    |=> takes WORD_COUNT * 8 bytes
+*/
+namespace btree::lsm {
+    template <typename K, typename V>
+    class SortedRun {
+        using EntryT = entry::Entry<K, V>;
+        using ValueType = typename EntryT::ValueType;
+
+        MappedFile<K, V> file;
+        int64_t m_count;
+        int64_t m_index_pos;
+        BloomFilter bloom;
+
+        static constexpr int64_t HEADER_SIZE = 3 * sizeof(int64_t);
+        static constexpr uint8_t VALUE_FLAG = 0;
+        static constexpr uint8_t REMOVED_FLAG = 1;
+
+        class RunCursor;
+    public:
+        class Builder;
+
+        const int64_t id;
+
+        SortedRun(const std::string& path, const int64_t id);
+
+        /** Returns nullopt if the run doesn't contain the KEY, the removed KEY is an entry with zero size */
+        std::optional<EntryT> find(const K key);
+
+        /** The cursor is positioned at the first KEY >= FROM */
+        std::unique_ptr<Cursor<K, V>> cursor(const K from);
+
+        int64_t count() const;
+        int64_t size_in_bytes() const;
+
+        /** The compaction reads the run from the beginning to the end */
+        void advise(const io::Advice advice);
+
+    private:
+        int64_t lower_bound(const K key);
+        int64_t read_entry_pos(const int64_t idx);
+        K read_key(const int64_t entry_pos);
+        EntryT read_entry(const int64_t entry_pos, int64_t& next_entry_pos);
+    };
+
+    /** Writes a new sorted run: the entries have to be added in the ascending order of keys */
+    template <typename K, typename V>
+    class SortedRun<K, V>::Builder {
+        MappedFile<K, V> file;
+        std::vector<int64_t> entry_pos;
+        std::vector<K> keys;
+    public:
+        explicit Builder(const std::string& path);
+
+        void add(const EntryT& e);
+        void finish();
+        int64_t count() const;
+    };
+}
+
+#include "sorted_run_impl.h"
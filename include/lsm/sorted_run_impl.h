@@ -0,0 +1,176 @@
+#pragma once
+
+namespace btree::lsm {
+    template <typename K, typename V>
+    class SortedRun<K, V>::RunCursor final : public Cursor<K, V> {
+        SortedRun& run;
+        int64_t idx;
+        int64_t pos;
+        K curr_key;
+    public:
+        RunCursor(SortedRun& run, const int64_t idx) : run(run), idx(idx), pos(0), curr_key() {
+            if (is_valid()) {
+                pos = run.read_entry_pos(idx);
+                curr_key = run.read_key(pos);
+            }
+        }
+
+        bool is_valid() const override { return idx < run.m_count; }
+        K key() const override { return curr_key; }
+
+        EntryT entry() override {
+            int64_t next_pos = 0;
+            return run.read_entry(pos, next_pos);
+        }
+
+        void next() override {
+            int64_t next_pos = 0;
+            run.read_entry(pos, next_pos);
+            if (++idx < run.m_count) {
+                // the entries are written one by one, so there is no need to look at the index
+                pos = next_pos;
+                curr_key = run.read_key(pos);
+            }
+        }
+    };
+
+    template <typename K, typename V>
+    SortedRun<K, V>::SortedRun(const std::string& path, const int64_t id) :
+        file(path, 0), m_count(0), m_index_pos(HEADER_SIZE), id(id)
+    {
+        if (file.is_empty())
+            throw std::logic_error("Sorted run is missing or empty: " + path);
+
+        file.set_pos(0);
+        m_count = file.read_int64();
+        m_index_pos = file.read_int64();
+        auto bloom_pos = file.read_int64();
+
+        file.set_pos(bloom_pos);
+        std::vector<uint64_t> words(file.read_int64());
+        auto hash_count = file.read_byte();
+        file.read_node_vector(words);
+        bloom = BloomFilter(std::move(words), hash_count);
+    }
+
+    template <typename K, typename V>
+    std::optional<typename SortedRun<K, V>::EntryT> SortedRun<K, V>::find(const K key) {
+        if (!bloom.may_contain(key))
+            return std::nullopt;
+
+        auto idx = lower_bound(key);
+        if (idx == m_count)
+            return std::nullopt;
+
+        auto pos = read_entry_pos(idx);
+        if (read_key(pos) != key)
+            return std::nullopt;
+
+        int64_t next_pos = 0;
+        return read_entry(pos, next_pos);
+    }
+
+    template <typename K, typename V>
+    std::unique_ptr<Cursor<K, V>> SortedRun<K, V>::cursor(const K from) {
+        return std::make_unique<RunCursor>(*this, lower_bound(from));
+    }
+
+    template <typename K, typename V>
+    int64_t SortedRun<K, V>::count() const {
+        return m_count;
+    }
+
+    template <typename K, typename V>
+    int64_t SortedRun<K, V>::size_in_bytes() const {
+        return m_index_pos;
+    }
+
+    template <typename K, typename V>
+    void SortedRun<K, V>::advise(const io::Advice advice) {
+        file.advise(advice);
+    }
+
+    template <typename K, typename V>
+    int64_t SortedRun<K, V>::lower_bound(const K key) {
+        int64_t left = 0;
+        int64_t right = m_count;
+        while (left < right) {
+            auto mid = left + (right - left) / 2;
+            if (read_key(read_entry_pos(mid)) < key)
+                left = mid + 1;
+            else
+                right = mid;
+        }
+        return left;
+    }
+
+    template <typename K, typename V>
+    int64_t SortedRun<K, V>::read_entry_pos(const int64_t idx) {
+        file.set_pos(m_index_pos + idx * static_cast<int64_t>(sizeof(int64_t)));
+        return file.read_int64();
+    }
+
+    template <typename K, typename V>
+    K SortedRun<K, V>::read_key(const int64_t entry_pos) {
+        file.set_pos(entry_pos);
+        return file.template read_next_primitive<K>();
+    }
+
+    template <typename K, typename V>
+    typename SortedRun<K, V>::EntryT SortedRun<K, V>::read_entry(const int64_t entry_pos, int64_t& next_entry_pos) {
+        file.set_pos(entry_pos);
+
+        K key = file.template read_next_primitive<K>();
+        if (file.read_byte() == REMOVED_FLAG) {
+            next_entry_pos = file.get_pos();
+            return EntryT(key, ValueType(), 0);
+        }
+
+        auto [value, size] = file.template read_next_data<ValueType>();
+        next_entry_pos = file.get_pos();
+        return EntryT(key, value, size);
+    }
+
+    template <typename K, typename V>
+    SortedRun<K, V>::Builder::Builder(const std::string& path) : file(path, 0) {
+        file.set_pos(HEADER_SIZE);
+    }
+
+    template <typename K, typename V>
+    void SortedRun<K, V>::Builder::add(const EntryT& e) {
+        entry_pos.push_back(file.get_pos());
+        keys.push_back(e.key);
+
+        file.write_next_primitive(e.key);
+        if (e.size_in_bytes == 0) {
+            file.write_next_primitive(REMOVED_FLAG);
+        } else {
+            file.write_next_primitive(VALUE_FLAG);
+            file.write_next_data(e.data, e.size_in_bytes);
+        }
+    }
+
+    template <typename K, typename V>
+    void SortedRun<K, V>::Builder::finish() {
+        auto index_pos = file.get_pos();
+        file.write_node_vector(entry_pos);
+
+        auto bloom_pos = file.get_pos();
+        BloomFilter bloom(static_cast<int64_t>(keys.size()));
+        for (const auto& key: keys)
+            bloom.add(key);
+        file.write_next_primitive(static_cast<int64_t>(bloom.words().size()));
+        file.write_next_primitive(bloom.hash_count());
+        file.write_node_vector(bloom.words());
+
+        file.set_pos(0);
+        file.write_next_primitive(static_cast<int64_t>(entry_pos.size()));
+        file.write_next_primitive(index_pos);
+        file.write_next_primitive(bloom_pos);
+    }
+
+    template <typename K, typename V>
+    int64_t SortedRun<K, V>::Builder::count() const {
+        return static_cast<int64_t>(entry_pos.size());
+    }
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils/utils.h"
+
+namespace btree::storage {
+    /**
+     * Node of the storage mount tree, several volumes can be mounted to one node:
+     *  - the volumes are ordered by priority, the volume mounted earlier wins if priorities are equal
+     *  - point queries return the data of the first volume with the KEY
+     *  - scan merges the volumes, the KEY of the higher priority volume shadows the same KEY of the lower ones
+     *  - set goes to the highest priority volume, remove removes the KEY from all the volumes of the node
+     */
+    template <typename K, typename V, typename VolumeType>
+    class MountNode final {
+        using ValueType = typename VolumeType::ValueType;
+
+        struct Mount {
+            VolumeType* volume;
+            int32_t priority;
+        };
+        std::vector<Mount> mounts;
+
+        /**
+         * Reads the volume in batches, so the merged scan doesn't keep the whole range in memory.
+         * The blobs are copied: the read value may be valid until the next reads only (see PositionalFile)
+         */
+        class VolumeCursor {
+            static constexpr size_t batch_size = 256;
+
+            VolumeType* const volume;
+            const K to;
+            std::vector<std::pair<K, utils::owned_value_t<V>>> batch;
+            size_t idx = 0;
+            bool is_last_batch = false;
+        public:
+            VolumeCursor(VolumeType* volume, const K from, const K to) : volume(volume), to(to) {
+                load(from);
+            }
+
+            bool is_valid() const { return idx < batch.size(); }
+            K key() const { return batch[idx].first; }
+            utils::conditional_t<std::is_pointer_v<V>, V, const V&> value() const {
+                if constexpr(std::is_pointer_v<V>)
+                    return reinterpret_cast<V>(batch[idx].second.data());
+                else
+                    return batch[idx].second;
+            }
+            /** The size of the blob value */
+            int32_t size() const {
+                if constexpr(std::is_pointer_v<V>)
+                    return static_cast<int32_t>(batch[idx].second.size());
+                else
+                    return 0;
+            }
+
+            void next() {
+                if (++idx < batch.size() || is_last_batch)
+                    return;
+
+                auto last_key = batch.back().first;
+                if (last_key == to)
+                    batch.clear();
+                else
+                    load(last_key + 1);
+            }
+        private:
+            void load(const K from) {
+                batch.clear();
+                idx = 0;
+                // the size is passed for the blob only
+                volume->scan(from, to, [this](const K key, const V& value, const auto... size) {
+                    if constexpr(std::is_pointer_v<V>)
+                        batch.emplace_back(key, utils::owned_value_t<V>(reinterpret_cast<const char*>(value), size...));
+                    else
+                        batch.emplace_back(key, value);
+                    return batch.size() < batch_size;
+                });
+                is_last_batch = batch.size() < batch_size;
+            }
+        };
+    public:
+        const std::string path;
+        MountNode* const parent;
+        int32_t child_count = 0;
+
+        MountNode(const std::string& path, MountNode* parent) : path(path), parent(parent) {}
+
+        /** Converts the path to the "/a/b/c" form: the empty and "." parts are skipped, ".." goes to the parent */
+        static std::string canonical_path(const std::string& path) {
+            std::vector<std::string> parts;
+            size_t begin = 0;
+            while (begin <= path.size()) {
+                auto end = std::min(path.find('/', begin), path.size());
+                auto part = path.substr(begin, end - begin);
+                if (part == "..") {
+                    if (!parts.empty())
+                        parts.pop_back();
+                } else if (!part.empty() && part != ".") {
+                    parts.push_back(std::move(part));
+                }
+                begin = end + 1;
+            }
+
+            std::string res;
+            for (const auto& part: parts)
+                res += "/" + part;
+            return res.empty() ? "/" : res;
+        }
+
+        /** Returns the parent path of the canonical path, the root has no parent */
+        static std::optional<std::string> parent_path(const std::string& canonical_path) {
+            if (canonical_path == "/")
+                return std::nullopt;
+            auto pos = canonical_path.rfind('/');
+            return pos == 0 ? "/" : canonical_path.substr(0, pos);
+        }
+
+        void mount(VolumeType* volume, const int32_t priority) {
+            unmount(volume);
+            auto it = std::find_if(mounts.begin(), mounts.end(), [priority](const Mount& m) {
+                return m.priority < priority;
+            });
+            mounts.insert(it, Mount{ volume, priority });
+        }
+
+        bool unmount(VolumeType* volume) {
+            auto it = std::find_if(mounts.begin(), mounts.end(), [volume](const Mount& m) {
+                return m.volume == volume;
+            });
+            if (it == mounts.end())
+                return false;
+            mounts.erase(it);
+            return true;
+        }
+
+        bool is_unused() const {
+            return mounts.empty() && child_count == 0;
+        }
+
+        size_t volume_count() const {
+            return mounts.size();
+        }
+
+        bool exist(const K key) const {
+            return std::any_of(mounts.begin(), mounts.end(), [key](const Mount& m) { return m.volume->exist(key); });
+        }
+
+        std::optional<V> get(const K key) const {
+            for (const auto& m: mounts) {
+                if (auto value = m.volume->get(key))
+                    return value;
+            }
+            return std::nullopt;
+        }
+
+        void set(const K key, const ValueType value) {
+            top_volume()->set(key, value);
+        }
+
+        void set(const K key, const V& value, const int32_t size) {
+            top_volume()->set(key, value, size);
+        }
+
+        bool remove(const K key) {
+            bool success = false;
+            for (const auto& m: mounts)
+                success |= m.volume->remove(key);
+            return success;
+        }
+
+        /** Calls fn(key, value) for every KEY in [FROM, TO] of the merged volumes, fn can return false to stop */
+        template <typename Fn>
+        void scan(const K from, const K to, Fn&& fn) const {
+            if (mounts.empty() || from > to)
+                return;
+            if (mounts.size() == 1) {
+                mounts.front().volume->scan(from, to, std::forward<Fn>(fn));
+                return;
+            }
+
+            std::vector<VolumeCursor> cursors;
+            cursors.reserve(mounts.size());
+            for (const auto& m: mounts)
+                cursors.emplace_back(m.volume, from, to);
+
+            // k-way merge: the cursors are ordered by priority, so the first cursor with the min KEY wins
+            const auto n = static_cast<int32_t>(cursors.size());
+            while (true) {
+                int32_t top = -1;
+                for (int32_t i = 0; i < n; ++i) {
+                    if (cursors[i].is_valid() && (top == -1 || cursors[i].key() < cursors[top].key()))
+                        top = i;
+                }
+                if (top == -1)
+                    return;
+
+                const K min_key = cursors[top].key();
+                bool proceed = utils::invoke_value_and_proceed(fn, min_key, cursors[top].value(), cursors[top].size());
+                for (auto& cursor: cursors) {
+                    if (cursor.is_valid() && cursor.key() == min_key)
+                        cursor.next();
+                }
+                if (!proceed)
+                    return;
+            }
+        }
+
+    private:
+        VolumeType* top_volume() const {
+            if (mounts.empty())
+                throw std::logic_error("No volume is mounted to " + path);
+            return mounts.front().volume;
+        }
+    };
+}
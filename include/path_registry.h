@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+
+namespace btree::storage {
+    /**
+     * Process-wide index { canonical volume path -> owner storage } for all storages of all types:
+     *  - the index is split into shards by the hash of the path, every shard has its own lock,
+     *    so the storages open and close volumes concurrently without a global lock
+     *  - the record is refcounted by the handles of the owner and is removed with the last handle
+     *  - the shared record has no owner: it keeps the volume that is shared by several storages,
+     *    the volume is closed with the last handle under the shard lock, so it can't be reopened before it's closed
+     */
+    class PathRegistry final {
+        struct Record {
+            const void* owner;
+            int32_t refcount;
+            std::shared_ptr<void> shared_volume;
+            const std::type_info* volume_type;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, Record> records;
+        };
+
+        static constexpr size_t shard_count = 64;
+        std::array<Shard, shard_count> shards;
+
+        PathRegistry() = default;
+
+        Shard& shard(const std::string& path) {
+            return shards[std::hash<std::string>{}(path) % shard_count];
+        }
+
+        void release(const std::string& path) {
+            auto& s = shard(path);
+            std::scoped_lock lock(s.mutex);
+            auto it = s.records.find(path);
+            if (it != s.records.end() && --it->second.refcount == 0)
+                s.records.erase(it);
+        }
+    public:
+        /** Keeps the path acquired by the owner until the handle is destroyed */
+        class Handle {
+            PathRegistry* registry;
+            std::string path;
+        public:
+            Handle(PathRegistry* registry, std::string path) : registry(registry), path(std::move(path)) {}
+
+            Handle(Handle&& other) noexcept : registry(other.registry), path(std::move(other.path)) {
+                other.registry = nullptr;
+            }
+
+            Handle(const Handle&) = delete;
+            Handle& operator=(const Handle&) = delete;
+            Handle& operator=(Handle&&) = delete;
+
+            ~Handle() {
+                if (registry)
+                    registry->release(path);
+            }
+        };
+
+        PathRegistry(const PathRegistry&) = delete;
+        PathRegistry& operator=(const PathRegistry&) = delete;
+
+        static PathRegistry& instance() {
+            // never destroyed: the static storages can release their paths after the exit from main
+            static auto* registry = new PathRegistry();
+            return *registry;
+        }
+
+        /** The absolute lexically normal path: "./a/../b.txt" and "b.txt" are the same volume */
+        static std::string canonical_path(const std::string& path) {
+            return std::filesystem::absolute(path).lexically_normal().string();
+        }
+
+        /** Throws if the canonical path is acquired by another owner */
+        Handle acquire(const std::string& path, const void* owner) {
+            auto& s = shard(path);
+            std::scoped_lock lock(s.mutex);
+            auto [it, inserted] = s.records.try_emplace(path, Record{ owner, 0, nullptr, nullptr });
+            if (it->second.owner != owner)
+                throw std::logic_error("Volume " + path + " is already opened in another storage!");
+            ++it->second.refcount;
+            return Handle(this, path);
+        }
+
+        /**
+         * Returns the shared volume of the path, create() opens it if the path isn't acquired.
+         * Throws if the path is acquired by the owner or the volume is shared with another type.
+         */
+        template <typename VolumeType, typename Factory>
+        std::pair<Handle, VolumeType*> acquire_shared(const std::string& path, Factory&& create) {
+            auto& s = shard(path);
+            std::scoped_lock lock(s.mutex);
+            auto it = s.records.find(path);
+            if (it == s.records.end()) {
+                std::shared_ptr<VolumeType> volume = create();
+                it = s.records.emplace(path, Record{ nullptr, 0, std::move(volume), &typeid(VolumeType) }).first;
+            } else if (!it->second.shared_volume) {
+                throw std::logic_error("Volume " + path + " is already opened in another storage!");
+            } else if (*it->second.volume_type != typeid(VolumeType)) {
+                throw std::logic_error("Volume " + path + " is shared by the storage of another type!");
+            }
+            ++it->second.refcount;
+            return { Handle(this, path), static_cast<VolumeType*>(it->second.shared_volume.get()) };
+        }
+
+        bool is_acquired(const std::string& path) {
+            auto& s = shard(path);
+            std::scoped_lock lock(s.mutex);
+            return s.records.count(path) != 0;
+        }
+    };
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <algorithm>
+#include <condition_variable>
+
+#include "concurrency/mpsc_ring.h"
+#include "utils/utils.h"
+
+namespace btree::volume {
+    /**
+     * Single writer of the volume (VolumeOptions::single_writer):
+     *  - any thread pushes the mutations to the lock-free MPSC ring without waiting for the volume lock
+     *  - one writer thread drains the ring in batches and applies every batch under the volume lock:
+     *    the mutations are sorted by key (the order of the mutations of one KEY is kept), repeated sets of one KEY
+     *    are coalesced into the last one
+     *  - wait_applied() is a barrier for readers: the mutations pushed by the calling thread are applied when
+     *    it returns, so every thread reads its own writes without waiting for the mutations of the other threads
+     *  - the mutation that throws doesn't stop the writer: the removals of its KEY in the batch get the exception,
+     *    the first exception of the sets is rethrown by the next set() or wait_applied() of any thread
+     */
+    template <typename K, typename V, typename VolumeT>
+    class SingleWriter final {
+        using ValueType = typename VolumeT::ValueType;
+        // the blob is copied, because the writer applies it after the producer returns
+        using StoredValue = utils::owned_value_t<V>;
+
+        enum class Kind : uint8_t { SET, REMOVE };
+
+        struct Mutation {
+            K key = K();
+            Kind kind = Kind::SET;
+            StoredValue value = StoredValue();
+            int32_t size = -1; // -1 for set(key, value) without size
+            std::promise<bool>* is_removed = nullptr;
+        };
+
+        static constexpr size_t max_batch_size = 4096;
+        static inline std::atomic<uint64_t> next_id = 0;
+
+        VolumeT& volume;
+        std::mutex& volume_mutex;
+        concurrency::MpscRing<Mutation> ring;
+        std::atomic<uint64_t> applied;
+        std::atomic<bool> is_stopped;
+        std::atomic<bool> writer_is_idle;
+        std::atomic<bool> has_error;
+        // the first exception of the applied mutations, it's guarded by IDLE_MUTEX
+        std::exception_ptr error;
+        const uint64_t id;
+        std::mutex idle_mutex;
+        std::condition_variable wakeup_cv;
+        std::condition_variable applied_cv;
+        std::thread writer;
+    public:
+        SingleWriter(VolumeT& volume, std::mutex& volume_mutex, const size_t queue_size) :
+            volume(volume), volume_mutex(volume_mutex), ring(queue_size),
+            applied(0), is_stopped(false), writer_is_idle(false), has_error(false), id(next_id++)
+        {
+            writer = std::thread([this] { run(); });
+        }
+
+        /** The pushed mutations are applied before the writer stops */
+        ~SingleWriter() {
+            {
+                std::scoped_lock lock(idle_mutex);
+                is_stopped = true;
+            }
+            wakeup_cv.notify_one();
+            writer.join();
+        }
+
+        void set(const K key, const ValueType value) {
+            rethrow_error();
+            push(Mutation{ key, Kind::SET, StoredValue(value), -1, nullptr });
+        }
+
+        void set(const K key, const V& value, const int32_t size) {
+            // the same as in the volume: the empty value isn't stored
+            if (size == 0)
+                return;
+            rethrow_error();
+            if constexpr(std::is_pointer_v<V>)
+                push(Mutation{ key, Kind::SET, StoredValue(value, size), size, nullptr });
+            else
+                push(Mutation{ key, Kind::SET, value, size, nullptr });
+        }
+
+        /** Waits for the writer to know whether the KEY existed */
+        bool remove(const K key) {
+            std::promise<bool> is_removed;
+            auto future = is_removed.get_future();
+            push(Mutation{ key, Kind::REMOVE, StoredValue(), -1, &is_removed });
+            return future.get();
+        }
+
+        void wait_applied() {
+            const auto target = last_ticket_of_thread();
+            if (applied.load(std::memory_order_acquire) < target) {
+                std::unique_lock lock(idle_mutex);
+                applied_cv.wait(lock, [this, target] { return applied.load(std::memory_order_acquire) >= target; });
+            }
+            rethrow_error();
+        }
+
+    private:
+        /** Rethrows the first exception of the applied mutations once */
+        void rethrow_error() {
+            if (!has_error.load(std::memory_order_acquire))
+                return;
+
+            std::exception_ptr e;
+            {
+                std::scoped_lock lock(idle_mutex);
+                std::swap(e, error);
+                has_error.store(false, std::memory_order_relaxed);
+            }
+            if (e)
+                std::rethrow_exception(e);
+        }
+
+        /** Keeps the first exception until it's rethrown */
+        void keep_error(std::exception_ptr e) {
+            std::scoped_lock lock(idle_mutex);
+            if (!error) {
+                error = std::move(e);
+                has_error.store(true, std::memory_order_release);
+            }
+        }
+
+        /** The ticket of the last mutation pushed by the calling thread, the writers are told by ID */
+        uint64_t& last_ticket_of_thread() {
+            thread_local std::unordered_map<uint64_t, uint64_t> last_tickets;
+            return last_tickets[id];
+        }
+
+        void push(Mutation&& m) {
+            last_ticket_of_thread() = ring.push(std::move(m));
+            // pairs with the fence of the writer: either the writer sees the mutation or the push sees the idle writer
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (writer_is_idle.load(std::memory_order_relaxed)) {
+                std::scoped_lock lock(idle_mutex);
+                wakeup_cv.notify_one();
+            }
+        }
+
+        void run() {
+            std::vector<Mutation> batch;
+            batch.reserve(max_batch_size);
+            uint64_t consumed = 0;
+            Mutation m;
+            while (true) {
+                while (batch.size() < max_batch_size && ring.pop(m))
+                    batch.push_back(std::move(m));
+
+                if (batch.empty()) {
+                    std::unique_lock lock(idle_mutex);
+                    if (is_stopped && ring.last_ticket() == consumed)
+                        return;
+                    writer_is_idle.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    // the push that doesn't see the idle writer is seen by the predicate, the other one notifies
+                    // under IDLE_MUTEX, so it can't happen between the predicate and the wait
+                    wakeup_cv.wait(lock, [this] { return is_stopped || ring.has_item(); });
+                    writer_is_idle.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+
+                {
+                    std::scoped_lock lock(volume_mutex);
+                    apply(batch);
+                }
+                consumed += batch.size();
+                batch.clear();
+                {
+                    std::scoped_lock lock(idle_mutex);
+                    applied.store(consumed, std::memory_order_release);
+                }
+                applied_cv.notify_all();
+            }
+        }
+
+        void apply(std::vector<Mutation>& batch) {
+            std::stable_sort(batch.begin(), batch.end(), [](const Mutation& lhs, const Mutation& rhs) {
+                return lhs.key < rhs.key;
+            });
+
+            std::vector<bool> is_removed;
+            for (size_t begin = 0, end = 0; begin < batch.size(); begin = end) {
+                const K key = batch[begin].key;
+                end = begin;
+                while (end < batch.size() && batch[end].key == key)
+                    ++end;
+
+                // the removals learn the result after the mutations of the KEY are applied
+                is_removed.assign(end - begin, false);
+                try {
+                    apply(batch, begin, end, is_removed);
+                } catch (...) {
+                    // the removals get the exception, the sets have no caller to wait for them
+                    bool has_set = false;
+                    for (auto i = begin; i < end; ++i) {
+                        if (batch[i].is_removed)
+                            batch[i].is_removed->set_exception(std::current_exception());
+                        has_set |= (batch[i].kind == Kind::SET);
+                    }
+                    if (has_set)
+                        keep_error(std::current_exception());
+                    continue;
+                }
+                for (auto i = begin; i < end; ++i) {
+                    if (batch[i].is_removed)
+                        batch[i].is_removed->set_value(is_removed[i - begin]);
+                }
+            }
+        }
+
+        /** Applies the mutations [BEGIN, END) of one KEY, IS_REMOVED gets the results of the removals */
+        void apply(const std::vector<Mutation>& batch, const size_t begin, const size_t end, std::vector<bool>& is_removed) {
+            const K key = batch[begin].key;
+
+            // the last set wins, a remove in between reports whether the KEY existed at its turn
+            const Mutation* last_set = nullptr;
+            std::optional<bool> exists;
+            bool must_remove = false;
+            for (auto i = begin; i < end; ++i) {
+                const auto& curr = batch[i];
+                if (curr.kind == Kind::SET) {
+                    last_set = &curr;
+                    exists = true;
+                } else {
+                    if (!exists)
+                        exists = volume.exist(key);
+                    is_removed[i - begin] = *exists;
+                    exists = false;
+                    last_set = nullptr;
+                    must_remove = true;
+                }
+            }
+
+            if (last_set)
+                apply_set(*last_set);
+            else if (must_remove)
+                volume.remove(key);
+        }
+
+        void apply_set(const Mutation& m) {
+            // only the blob is set with the size, the size of the string and the arithmetic value is known
+            if constexpr(std::is_pointer_v<V>)
+                volume.set(m.key, m.value.data(), m.size);
+            else
+                volume.set(m.key, m.value);
+        }
+    };
+}
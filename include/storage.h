@@ -1,59 +1,285 @@
 #pragma once
 
+#include <mutex>
 #include <unordered_map>
-#include <unordered_set>
 
 #include "volume.h"
+#include "mount_node.h"
+#include "path_registry.h"
+#include "async/executor.h"
 
 namespace btree::storage {
-    template <typename K, typename V, bool SupportMultithreading>
+    template <typename K, typename V, bool SupportMultithreading, typename Engine = engine::DefaultEngine>
     class StorageBase final {
         class VolumeWrapper;
+        class MountWrapper;
 
-        using StorageMap = std::unordered_set<StorageBase*>;
-        inline static StorageMap storage_map;
+        using VolumeType = std::conditional_t<SupportMultithreading, volume::VolumeMT<K, V, Engine>, volume::Volume<K, V, Engine>>;
 
-        using VolumeType = std::conditional_t<SupportMultithreading, volume::VolumeMT<K, V>, volume::Volume<K, V>>;
-        std::unordered_map<std::string, std::unique_ptr<VolumeType>> volume_map;
+        /** The volume with the strand of its async operations */
+        struct VolumeState {
+            VolumeType volume;
+            std::once_flag strand_flag;
+            std::optional<async::Strand> m_strand;
+
+            VolumeState(const std::string& path, const int16_t user_t, const VolumeOptions& options) :
+                volume(path, user_t, options) {}
+
+            ~VolumeState() {
+                // the queued operations are done before the volume is closed
+                if (m_strand)
+                    async::Executor::submit(*m_strand, [] {}).wait();
+            }
+
+            async::Strand& strand() {
+                std::call_once(strand_flag, [this] { m_strand.emplace(async::Executor::instance().make_strand()); });
+                return *m_strand;
+            }
+        };
+
+        struct OpenedVolume {
+            // the path is released after the volume is closed
+            PathRegistry::Handle handle;
+            // nullptr for the shared volume: it's owned by the registry
+            std::unique_ptr<VolumeState> owned_state;
+            VolumeState* state;
+        };
+        // the canonical path -> the volume opened by this storage
+        std::unordered_map<std::string, OpenedVolume> volume_map;
+        // guards the volume map and the mount tree of this storage only
+        std::mutex storage_mutex;
+
+        using MountNodeT = MountNode<K, V, VolumeType>;
+        // the canonical path -> the mount node, so the node is found in O(path length) for any number of nodes
+        std::unordered_map<std::string, std::unique_ptr<MountNodeT>> mount_map;
+        std::unordered_map<VolumeType*, std::vector<MountNodeT*>> mounts_by_volume;
 
     public:
         using VolumeT = VolumeWrapper;
+        using MountT = MountWrapper;
 
-        explicit StorageBase() {
-            storage_map.insert(this);
-        }
+        explicit StorageBase() = default;
+
+        StorageBase(const StorageBase&) = delete;
+        StorageBase& operator=(const StorageBase&) = delete;
 
         ~StorageBase() {
+            mount_map.clear();
             volume_map.clear();
-            storage_map.erase(this);
         }
 
-        VolumeT open_volume(const std::string& path, const int16_t user_t) {
-            for (const auto& storage: storage_map) {
-                auto& curr_volume_map = storage->volume_map;
-                auto it = curr_volume_map.find(path);
-                if (it != curr_volume_map.end()) {
-                    if (this != storage) {
-                        throw std::logic_error("Volume " + it->first + " is already opened in another storage!");
-                    } else {
-                        return VolumeT(it->second.get());
-                    }
+        /** Throws if the volume is opened by another storage of this process */
+        VolumeT open_volume(const std::string& path, const int16_t user_t, const VolumeOptions& options = VolumeOptions()) {
+            const auto& canonical_path = PathRegistry::canonical_path(path);
+            std::scoped_lock lock(storage_mutex);
+            auto it = volume_map.find(canonical_path);
+            if (it != volume_map.end())
+                return VolumeT(it->second.state);
+
+            auto handle = PathRegistry::instance().acquire(canonical_path, this);
+            auto state = std::make_unique<VolumeState>(path, user_t, options);
+            auto* state_ptr = state.get();
+            volume_map.emplace(canonical_path, OpenedVolume{ std::move(handle), std::move(state), state_ptr });
+            return VolumeT(state_ptr);
+        }
+
+        /**
+         * Opens the existing volume in the read-only mode, the volume is shared by all storages of this type
+         * that open it this way: the files are mapped once and closed by the last storage.
+         * Throws if the volume is opened by open_volume(...) in another storage.
+         */
+        VolumeT open_shared_volume(const std::string& path, const int16_t user_t,
+                                   const VolumeOptions& options = VolumeOptions())
+        {
+            const auto& canonical_path = PathRegistry::canonical_path(path);
+            std::scoped_lock lock(storage_mutex);
+            auto it = volume_map.find(canonical_path);
+            if (it != volume_map.end())
+                return VolumeT(it->second.state);
+
+            validate(std::filesystem::exists(path), error_msg::volume_does_not_exist_msg, path);
+            auto [handle, state_ptr] = PathRegistry::instance().acquire_shared<VolumeState>(canonical_path, [&] {
+                auto read_only_options = options;
+                read_only_options.read_only = true;
+                return std::make_shared<VolumeState>(path, user_t, read_only_options);
+            });
+            volume_map.emplace(canonical_path, OpenedVolume{ std::move(handle), nullptr, state_ptr });
+            return VolumeT(state_ptr);
+        }
+
+        bool close_volume(const VolumeT& v) {
+            const auto& canonical_path = PathRegistry::canonical_path(v.path());
+            std::scoped_lock lock(storage_mutex);
+            auto it = mounts_by_volume.find(v.ptr);
+            if (it != mounts_by_volume.end()) {
+                auto nodes = std::move(it->second);
+                mounts_by_volume.erase(it);
+                for (auto* node: nodes) {
+                    node->unmount(v.ptr);
+                    remove_if_unused(node);
                 }
             }
-            auto[pos, success] = volume_map.emplace(path, std::make_unique<VolumeType>(path, user_t));
-            return VolumeT(pos->second.get());
+            return volume_map.erase(canonical_path);
         }
 
-        bool close_volume(const VolumeT& v) {
-            return volume_map.erase(v.path());
+        /**
+         * Mounts the volume opened in this storage to the mount node, the missing nodes of the path are created.
+         * Mounting the same volume again changes its priority.
+         */
+        MountT mount(const std::string& mount_path, const VolumeT& v, const int32_t priority = 0) {
+            std::scoped_lock lock(storage_mutex);
+            auto* node = get_or_create_node(MountNodeT::canonical_path(mount_path));
+            auto& nodes = mounts_by_volume[v.ptr];
+            if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+                nodes.push_back(node);
+            node->mount(v.ptr, priority);
+            return MountT(node);
+        }
+
+        bool unmount(const std::string& mount_path, const VolumeT& v) {
+            std::scoped_lock lock(storage_mutex);
+            auto it = mount_map.find(MountNodeT::canonical_path(mount_path));
+            if (it == mount_map.end())
+                return false;
+
+            auto* node = it->second.get();
+            if (!node->unmount(v.ptr))
+                return false;
+
+            auto& nodes = mounts_by_volume[v.ptr];
+            nodes.erase(std::find(nodes.begin(), nodes.end(), node));
+            if (nodes.empty())
+                mounts_by_volume.erase(v.ptr);
+            remove_if_unused(node);
+            return true;
+        }
+
+        /** The mount handle is valid until the last volume is unmounted from the node and it has no child nodes */
+        std::optional<MountT> find_mount(const std::string& mount_path) {
+            std::scoped_lock lock(storage_mutex);
+            auto it = mount_map.find(MountNodeT::canonical_path(mount_path));
+            if (it == mount_map.end())
+                return std::nullopt;
+            return MountT(it->second.get());
         }
 
     private:
+        MountNodeT* get_or_create_node(const std::string& path) {
+            auto it = mount_map.find(path);
+            if (it != mount_map.end())
+                return it->second.get();
+
+            MountNodeT* parent = nullptr;
+            if (auto parent_path = MountNodeT::parent_path(path)) {
+                parent = get_or_create_node(*parent_path);
+                ++parent->child_count;
+            }
+            auto [pos, success] = mount_map.emplace(path, std::make_unique<MountNodeT>(path, parent));
+            return pos->second.get();
+        }
+
+        void remove_if_unused(MountNodeT* node) {
+            while (node && node->is_unused()) {
+                auto* parent = node->parent;
+                if (parent)
+                    --parent->child_count;
+                mount_map.erase(node->path);
+                node = parent;
+            }
+        }
+
         class VolumeWrapper {
+            friend class StorageBase;
+
+            VolumeState* const state;
             VolumeType* const ptr;
             using ValueType = typename VolumeType::ValueType;
         public:
-            explicit VolumeWrapper(VolumeType* ptr) : ptr(ptr) {}
+            explicit VolumeWrapper(VolumeState* state) : state(state), ptr(&state->volume) {}
+
+            bool exist(const K key) const { return ptr->exist(key); }
+
+            void set(const K key, const ValueType value) { ptr->set(key, value); }
+
+            void set(const K key, const V& value, const int32_t size) { ptr->set(key, value, size); }
+
+            void set(const K key, const ValueType value, const std::chrono::milliseconds ttl) {
+                ptr->set(key, value, ttl);
+            }
+
+            void set(const K key, const V& value, const int32_t size, const std::chrono::milliseconds ttl) {
+                ptr->set(key, value, size, ttl);
+            }
+
+            std::optional<V> get(const K key) const { return ptr->get(key); }
+
+            std::vector<std::optional<utils::owned_value_t<V>>> multi_get(const std::vector<K>& keys) const { return ptr->multi_get(keys); }
+
+            bool remove(const K key) { return ptr->remove(key); }
+
+            template <typename Fn>
+            void scan(const K from, const K to, Fn&& fn) { ptr->scan(from, to, std::forward<Fn>(fn)); }
+
+            /**
+             * The B-tree engine only: read-modify-write of the KEY with one lookup, it's atomic for VolumeMT.
+             * fetch_add is for the arithmetic values, the others are for the arithmetic and (w)string values
+             */
+            template <typename U = V, utils::enable_if_t<std::is_arithmetic_v<U>> = true>
+            V fetch_add(const K key, const V delta) { return ptr->fetch_add(key, delta); }
+
+            template <typename U = V, utils::enable_if_t<!std::is_pointer_v<U>> = true>
+            bool compare_exchange(const K key, const ValueType expected, const ValueType desired) {
+                return ptr->compare_exchange(key, expected, desired);
+            }
+
+            template <typename U = V, utils::enable_if_t<!std::is_pointer_v<U>> = true>
+            std::optional<V> exchange(const K key, const ValueType value) { return ptr->exchange(key, value); }
+
+            template <typename Fn, typename U = V, utils::enable_if_t<!std::is_pointer_v<U>> = true>
+            bool update(const K key, Fn&& fn) { return ptr->update(key, std::forward<Fn>(fn)); }
+
+            /** The B-tree engine only, see VolumeOptions::access_advice */
+            void advise(const io::Advice advice) { ptr->advise(advice); }
+
+            /** The B-tree engine only, see VolumeOptions::value_log_threshold_in_bytes */
+            int64_t collect_value_log_garbage() { return ptr->collect_value_log_garbage(); }
+
+            std::string path() const { return ptr->path; }
+
+            /**
+             * The async operations are queued to the strand of the volume and run on the library executor,
+             * the future holds the result or the thrown exception. The volume waits for the queued operations
+             * when it's closed, so it mustn't be closed from the executor thread.
+             */
+            std::future<std::optional<V>> async_get(const K key) {
+                return async::Executor::submit(state->strand(), [p = ptr, key] { return p->get(key); });
+            }
+
+            std::future<std::vector<std::optional<utils::owned_value_t<V>>>> async_multi_get(std::vector<K> keys) {
+                return async::Executor::submit(state->strand(), [p = ptr, keys = std::move(keys)] {
+                    return p->multi_get(keys);
+                });
+            }
+
+            /** The value is copied, the blob has to be alive until the future is ready */
+            std::future<void> async_set(const K key, const ValueType value) {
+                return async::Executor::submit(state->strand(), [p = ptr, key, value = V(value)] { p->set(key, value); });
+            }
+
+            std::future<void> async_set(const K key, const V& value, const int32_t size) {
+                return async::Executor::submit(state->strand(), [p = ptr, key, value, size] { p->set(key, value, size); });
+            }
+
+            std::future<bool> async_remove(const K key) {
+                return async::Executor::submit(state->strand(), [p = ptr, key] { return p->remove(key); });
+            }
+        };
+
+        class MountWrapper {
+            MountNodeT* const ptr;
+            using ValueType = typename VolumeType::ValueType;
+        public:
+            explicit MountWrapper(MountNodeT* ptr) : ptr(ptr) {}
 
             bool exist(const K key) const { return ptr->exist(key); }
 
@@ -65,14 +291,19 @@ namespace btree::storage {
 
             bool remove(const K key) { return ptr->remove(key); }
 
+            template <typename Fn>
+            void scan(const K from, const K to, Fn&& fn) const { ptr->scan(from, to, std::forward<Fn>(fn)); }
+
+            size_t volume_count() const { return ptr->volume_count(); }
+
             std::string path() const { return ptr->path; }
         };
     };
 }
 namespace btree {
-    template <typename K, typename V>
-    using Storage = storage::StorageBase<K, V, false>;
+    template <typename K, typename V, typename Engine = engine::DefaultEngine>
+    using Storage = storage::StorageBase<K, V, false, Engine>;
 
-    template <typename K, typename V>
-    using StorageMT = storage::StorageBase<K, V, true>;
+    template <typename K, typename V, typename Engine = engine::DefaultEngine>
+    using StorageMT = storage::StorageBase<K, V, true, Engine>;
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+#include "expiry_index.h"
+
+namespace btree::ttl {
+    /** Expiration time is stored as milliseconds since the epoch, 0 means that the KEY never expires */
+    inline int64_t now() {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    inline int64_t deadline(const std::chrono::milliseconds ttl) {
+        return now() + ttl.count();
+    }
+
+    /**
+     * Active expiration: the expire cycle pops the records with EXPIRES_AT <= now from the expiry index in batches
+     * until there are no expired records or the CPU budget is spent. The cost of the cycle depends on the number of
+     * expired keys only. The accessed keys are removed by the volume lazily.
+     */
+    template <typename K>
+    class Expiration {
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr int64_t keys_per_batch = 256;
+
+        ExpiryIndex<K> expiry_index;
+        const Clock::duration cycle_period;
+        const Clock::duration cycle_budget;
+        Clock::time_point next_cycle;
+    public:
+        Expiration(const std::string& index_path, const std::chrono::milliseconds cycle_period,
+                   const int32_t cycle_cpu_percent) :
+            expiry_index(index_path),
+            cycle_period(cycle_period),
+            cycle_budget(cycle_period * std::clamp(cycle_cpu_percent, 1, 100) / 100),
+            next_cycle(Clock::now() + cycle_period) {}
+
+        ExpiryIndex<K>& index() { return expiry_index; }
+
+        void on_set(const K key, const int64_t expires_at) {
+            if (expires_at != 0)
+                expiry_index.insert(expires_at, key);
+        }
+
+        void on_remove(const K key, const int64_t expires_at) {
+            if (expires_at != 0)
+                expiry_index.erase(expires_at, key);
+        }
+
+        bool is_cycle_due() const {
+            return Clock::now() >= next_cycle;
+        }
+
+        /**
+         * Calls remove_fn(key, expires_at) for the expired records, it returns false for the stale ones.
+         * Returns the number of removed keys.
+         */
+        template <typename RemoveFn>
+        int64_t run_cycle(RemoveFn&& remove_fn) {
+            const auto start = Clock::now();
+            next_cycle = start + cycle_period;
+
+            const auto curr_time = now();
+            int64_t removed = 0;
+            auto remove = [&remove_fn, &removed](const K key, const int64_t expires_at) {
+                removed += remove_fn(key, expires_at);
+            };
+            while (expiry_index.pop_expired(curr_time, keys_per_batch, remove) == keys_per_batch) {
+                if (Clock::now() - start >= cycle_budget)
+                    break;
+            }
+            return removed;
+        }
+    };
+}
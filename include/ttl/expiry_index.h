@@ -0,0 +1,86 @@
+#pragma once
+
+#include <set>
+#include <memory>
+
+#include "io/mapped_file.h"
+
+/**
+ * Expiry index structures (a sidecar file next to the volume file):
+ *
+ * - Header (40 bytes):
+ *     - COUNT                    |=> takes 8 bytes -> the number of records in file
+ *     - FIRST                    |=> takes 8 bytes -> the number of reaped records at the beginning of the file
+ *     - VOLUME_END               |=> takes 8 bytes -> the volume file size the index was synced with on close
+ *     - STATE                    |=> takes 1 byte  -> STATE = 0 if the index was closed properly, 1 otherwise
+ *     - RESERVED                 |=> takes 7 bytes
+ *     - ERASED                   |=> takes 8 bytes -> the number of erased records after FIRST
+ *
+ * - Record (8 + KEY_SIZE bytes), records are sorted by { |EXPIRES_AT|, KEY }:
+ *     - EXPIRES_AT               |=> takes 8 bytes        -> milliseconds since the epoch, negated for the erased record
+ *     - KEY                      |=> takes KEY_SIZE bytes
+ *
+ * New records are kept in memory and merged with the file records into a new file when there are too many of them.
+ * The record of the removed or overwritten KEY is erased by the volume in the same operation: the pending one is
+ * dropped, the file one is found by the binary search and marked in place. The erased records are skipped by
+ * pop_expired(...) and dropped by the merge.
+*/
+namespace btree::ttl {
+    template <typename K>
+    class ExpiryIndex {
+        using Record = std::pair<int64_t, K>;
+        using File = MappedFile<K, int64_t>;
+
+        const std::string path;
+        std::unique_ptr<File> file;
+        int64_t m_count;
+        int64_t m_first;
+        int64_t m_erased;
+        std::set<Record> pending;
+
+        static constexpr int64_t COUNT_POS = 0;
+        static constexpr int64_t FIRST_POS = 8;
+        static constexpr int64_t VOLUME_END_POS = 16;
+        static constexpr int64_t STATE_POS = 24;
+        static constexpr int64_t ERASED_POS = 32;
+        static constexpr int64_t HEADER_SIZE = 40;
+        static constexpr int64_t RECORD_SIZE = sizeof(int64_t) + sizeof(K);
+
+        static constexpr size_t MIN_PENDING_COUNT = 64 * 1024;
+        static constexpr uint8_t STATE_CLOSED = 0;
+        static constexpr uint8_t STATE_OPENED = 1;
+    public:
+        explicit ExpiryIndex(const std::string& path);
+
+        /** The index can be trusted only if it was closed properly together with the volume of VOLUME_END size */
+        bool is_synced_with(const int64_t volume_end);
+
+        /** Marks the index as opened, so it's rebuilt on the next open if the process doesn't call close(...) */
+        void open();
+        void close(const int64_t volume_end);
+
+        void insert(const int64_t expires_at, const K key);
+        /** Drops the pending record and marks the file one as erased */
+        void erase(const int64_t expires_at, const K key);
+        void clear();
+
+        /**
+         * Removes up to MAX_COUNT records with EXPIRES_AT <= NOW in the ascending order and calls fn(key, expires_at)
+         * for each of them, returns the number of removed records
+         */
+        template <typename Fn>
+        int64_t pop_expired(const int64_t now, const int64_t max_count, Fn&& fn);
+
+        int64_t size() const;
+    private:
+        /** The record at IDX of the file, EXPIRES_AT of the erased one is negative */
+        Record read_record(const int64_t idx);
+        /** The index of the RECORD in the not reaped part of the file, -1 if there is no such one */
+        int64_t find_record(const Record& record);
+        void write_counters();
+        static void write_header(File& f, const int64_t count, const int64_t first, const int64_t erased);
+        void merge();
+    };
+}
+
+#include "expiry_index_impl.h"
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+namespace btree::ttl {
+    template <typename K>
+    ExpiryIndex<K>::ExpiryIndex(const std::string& path) :
+        path(path), file(std::make_unique<File>(path, 0)), m_count(0), m_first(0), m_erased(0)
+    {
+        if (file->is_empty()) {
+            write_header(*file, m_count, m_first, m_erased);
+            return;
+        }
+
+        file->set_pos(COUNT_POS);
+        m_count = file->read_int64();
+        m_first = file->read_int64();
+        file->set_pos(ERASED_POS);
+        m_erased = file->read_int64();
+    }
+
+    template <typename K>
+    bool ExpiryIndex<K>::is_synced_with(const int64_t volume_end) {
+        file->set_pos(VOLUME_END_POS);
+        auto synced_volume_end = file->read_int64();
+        auto state = file->read_byte();
+        return (state == STATE_CLOSED) && (synced_volume_end == volume_end);
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::open() {
+        file->set_pos(STATE_POS);
+        file->write_next_primitive(STATE_OPENED);
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::close(const int64_t volume_end) {
+        merge();
+        file->set_pos(VOLUME_END_POS);
+        file->write_next_primitive(volume_end);
+        file->write_next_primitive(STATE_CLOSED);
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::insert(const int64_t expires_at, const K key) {
+        pending.emplace(expires_at, key);
+        // the merge rewrites the whole file, so the limit grows with the index to keep the amortized cost constant
+        if (pending.size() >= std::max(MIN_PENDING_COUNT, static_cast<size_t>(m_count - m_first) / 16))
+            merge();
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::erase(const int64_t expires_at, const K key) {
+        pending.erase({ expires_at, key });
+        auto idx = find_record({ expires_at, key });
+        if (idx < 0)
+            return;
+
+        file->set_pos(HEADER_SIZE + idx * RECORD_SIZE);
+        file->write_next_primitive(-expires_at);
+        ++m_erased;
+        write_counters();
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::clear() {
+        pending.clear();
+        m_count = m_first = m_erased = 0;
+        write_header(*file, m_count, m_first, m_erased);
+    }
+
+    template <typename K>
+    template <typename Fn>
+    int64_t ExpiryIndex<K>::pop_expired(const int64_t now, const int64_t max_count, Fn&& fn) {
+        // the records are removed from the index before the callback, so it's allowed to modify the index
+        std::vector<Record> expired;
+        auto it = pending.begin();
+        while (static_cast<int64_t>(expired.size()) < max_count) {
+            const bool has_file_record = m_first < m_count;
+            const bool has_pending_record = it != pending.end();
+            if (!has_file_record && !has_pending_record)
+                break;
+
+            auto file_record = has_file_record ? read_record(m_first) : Record{};
+            if (has_file_record && file_record.first < 0) {
+                ++m_first;
+                --m_erased;
+                continue;
+            }
+            bool from_file = has_file_record && (!has_pending_record || file_record <= *it);
+            const auto& record = from_file ? file_record : *it;
+            if (record.first > now)
+                break;
+
+            if (expired.empty() || expired.back() != record)
+                expired.push_back(record);
+            if (from_file)
+                ++m_first;
+            else
+                ++it;
+        }
+        pending.erase(pending.begin(), it);
+        write_counters();
+
+        for (const auto& [expires_at, key]: expired)
+            fn(key, expires_at);
+        return static_cast<int64_t>(expired.size());
+    }
+
+    template <typename K>
+    int64_t ExpiryIndex<K>::size() const {
+        return m_count - m_first - m_erased + static_cast<int64_t>(pending.size());
+    }
+
+    template <typename K>
+    typename ExpiryIndex<K>::Record ExpiryIndex<K>::read_record(const int64_t idx) {
+        file->set_pos(HEADER_SIZE + idx * RECORD_SIZE);
+        auto expires_at = file->read_int64();
+        return { expires_at, file->template read_next_primitive<K>() };
+    }
+
+    template <typename K>
+    int64_t ExpiryIndex<K>::find_record(const Record& record) {
+        auto lo = m_first;
+        auto hi = m_count;
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            auto [expires_at, key] = read_record(mid);
+            if (Record{ std::abs(expires_at), key } < record)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        // the erased record doesn't match, its EXPIRES_AT is negative
+        return (lo < m_count && read_record(lo) == record) ? lo : -1;
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::write_counters() {
+        file->set_pos(FIRST_POS);
+        file->write_next_primitive(m_first);
+        file->set_pos(ERASED_POS);
+        file->write_next_primitive(m_erased);
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::write_header(File& f, const int64_t count, const int64_t first, const int64_t erased) {
+        f.set_pos(COUNT_POS);
+        f.write_next_primitive(count);
+        f.write_next_primitive(first);
+        f.write_next_primitive(int64_t(0));
+        f.write_next_primitive(STATE_OPENED);
+        for (int i = 0; i < 7; ++i)
+            f.write_next_primitive(uint8_t(0));
+        f.write_next_primitive(erased);
+    }
+
+    template <typename K>
+    void ExpiryIndex<K>::merge() {
+        if (pending.empty() && m_first == 0 && m_erased == 0)
+            return;
+
+        // the reaped and erased records are dropped, the file records are merged with the pending ones in one sequential pass
+        const auto& tmp_path = path + ".tmp";
+        int64_t count = 0;
+        {
+            File merged(tmp_path, 0);
+            merged.set_pos(HEADER_SIZE);
+            auto write_record = [&merged, &count](const Record& r) {
+                merged.write_next_primitive(r.first);
+                merged.write_next_primitive(r.second);
+                ++count;
+            };
+
+            auto it = pending.begin();
+            for (auto idx = m_first; idx < m_count; ++idx) {
+                auto record = read_record(idx);
+                if (record.first < 0)
+                    continue;
+                for (; it != pending.end() && *it < record; ++it)
+                    write_record(*it);
+                if (it != pending.end() && *it == record)
+                    ++it;
+                write_record(record);
+            }
+            for (; it != pending.end(); ++it)
+                write_record(*it);
+
+            write_header(merged, count, 0, 0);
+        }
+
+        file.reset();
+        std::filesystem::rename(tmp_path, path);
+        file = std::make_unique<File>(path, 0);
+        m_count = count;
+        m_first = m_erased = 0;
+        pending.clear();
+    }
+}
@@ -14,4 +14,39 @@ namespace btree::error_msg {
 
     constexpr std::string_view wrong_element_size_msg =
             "The ELEMENT_SIZE for your tree doesn't equal to the ELEMENT_SIZE used in storage: ";
+
+    constexpr std::string_view wrong_buffer_size_msg =
+            "The BUFFER_SIZE for your tree doesn't equal to the BUFFER_SIZE used in storage: ";
+
+    constexpr std::string_view wrong_flags_msg =
+            "The FLAGS (enabled TTL, node file) for your tree don't equal to the FLAGS used in storage: ";
+
+    constexpr std::string_view read_only_volume_msg =
+            "The volume is opened in the read-only mode: ";
+
+    constexpr std::string_view volume_does_not_exist_msg =
+            "The shared volume can't be created, it has to exist: ";
+
+    constexpr std::string_view io_error_msg =
+            "The read or write of the volume file failed: ";
+
+    constexpr std::string_view wrong_node_file_msg =
+            "The node file doesn't belong to a volume with the internal nodes in the node file: ";
+
+    constexpr std::string_view compact_pos_overflow_msg =
+            "The volume with the compact node positions can't have more than 2^32 - 1 nodes or 256 TB of entries: ";
+
+    constexpr std::string_view inline_leaf_values_msg =
+            "The leaves keep the copies of the arithmetic values only, the volume can't have the inline leaf values: ";
+
+    constexpr std::string_view compress_node_keys_msg =
+            "The keys of the leaves are compressed with the inline leaf values only, the volume can't compress them: ";
+
+    constexpr std::string_view wrong_value_log_msg =
+            "The value log segment is missing or doesn't belong to a volume with the value log: ";
+
+    constexpr std::string_view wrong_value_codec_msg =
+            "The value of the entry has an unknown codec or the compressed value is broken: ";
+    constexpr std::string_view ttl_is_disabled_msg =
+            "TTL isn't enabled in VolumeOptions for the volume: ";
 }
\ No newline at end of file
@@ -1,7 +1,18 @@
 #pragma once
 
+#include <bitset>
+#include <cstring>
 #include <string>
 #include <vector>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 namespace utils {
 #if _WIN64 || __amd64__
@@ -33,12 +44,104 @@ namespace utils {
         using type = typename T::value_type;
     };
 
+    /** Calls fn(args...): the callback can return false to stop the iteration, the void callback never stops it */
+    template <typename Fn, typename... Args>
+    bool invoke_and_proceed(Fn& fn, Args&&... args) {
+        if constexpr(std::is_same_v<std::invoke_result_t<Fn&, Args...>, bool>) {
+            return fn(std::forward<Args>(args)...);
+        } else {
+            fn(std::forward<Args>(args)...);
+            return true;
+        }
+    }
+
+    /** Calls fn(key, value) like invoke_and_proceed, the callback of the blob can take its SIZE as the third argument */
+    template <typename Fn, typename K, typename V>
+    bool invoke_value_and_proceed(Fn& fn, const K key, const V& value, const int32_t size) {
+        if constexpr(std::is_pointer_v<V> && std::is_invocable_v<Fn&, const K, const V&, const int32_t>)
+            return invoke_and_proceed(fn, key, value, size);
+        else
+            return invoke_and_proceed(fn, key, value);
+    }
+
+    /** Hints the CPU to load the cache line of the address, the address may be invalid */
+    inline void prefetch(const void* address) {
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+        __builtin_prefetch(address, 0, 3);
+#endif
+    }
+
+    /**
+     * The number of the values less than VALUE in the sorted array of N packed unsigned T (the lower bound):
+     * the binary search narrows the range, SSE2 compares the rest by 16 bytes
+     */
+    template <typename T>
+    int32_t count_less(const uint8_t* data, int32_t n, const T value) {
+        static_assert(std::is_unsigned_v<T> && sizeof(T) <= sizeof(uint32_t));
+        auto at = [data](const int32_t idx) {
+            T v;
+            std::memcpy(&v, data + idx * sizeof(T), sizeof(T));
+            return v;
+        };
+
+        int32_t first = 0;
+        while (n > 64) {
+            const auto half = n / 2;
+            if (at(first + half) < value) {
+                first += half + 1;
+                n -= half + 1;
+            } else {
+                n = half;
+            }
+        }
+
+        int32_t i = first;
+        const int32_t end = first + n;
+#if defined(__SSE2__) || defined(_M_X64)
+        // the unsigned values are compared as signed with the flipped top bit
+        constexpr int32_t lanes = 16 / sizeof(T);
+        __m128i sign, target;
+        if constexpr(sizeof(T) == 1) {
+            sign = _mm_set1_epi8(static_cast<char>(0x80));
+            target = _mm_xor_si128(_mm_set1_epi8(static_cast<char>(value)), sign);
+        } else if constexpr(sizeof(T) == 2) {
+            sign = _mm_set1_epi16(static_cast<short>(0x8000));
+            target = _mm_xor_si128(_mm_set1_epi16(static_cast<short>(value)), sign);
+        } else {
+            sign = _mm_set1_epi32(static_cast<int>(0x80000000));
+            target = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(value)), sign);
+        }
+        int32_t less = 0;
+        for (; i + lanes <= end; i += lanes) {
+            auto v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * sizeof(T))), sign);
+            __m128i lt;
+            if constexpr(sizeof(T) == 1)
+                lt = _mm_cmplt_epi8(v, target);
+            else if constexpr(sizeof(T) == 2)
+                lt = _mm_cmplt_epi16(v, target);
+            else
+                lt = _mm_cmplt_epi32(v, target);
+            less += static_cast<int32_t>(std::bitset<16>(_mm_movemask_epi8(lt)).count() / sizeof(T));
+        }
+        first += less;
+#endif
+        for (; i < end; ++i)
+            first += at(i) < value;
+        return first;
+    }
+
     template <bool Condition>
     using enable_if_t = typename std::enable_if<Condition, bool>::type;
 
     template <bool Condition, typename TrueType, typename FalseType>
     using conditional_t = typename std::conditional_t<Condition, TrueType, FalseType>;
 
+    /** The value that owns its data: the blob is copied to the string of its bytes */
+    template <typename V>
+    using owned_value_t = conditional_t<std::is_pointer_v<V>, std::string, V>;
+
     template <typename T>
     struct is_string {
         static constexpr bool value = false;
@@ -2,76 +2,667 @@
 
 #include <string>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
 
 #include "io/io_manager.h"
 #include "btree_impl/btree.h"
+#include "index/hash_index.h"
+#include "volume_options.h"
+#include "engine.h"
+#include "lsm/memtable.h"
+#include "ttl/expiration.h"
+#include "single_writer.h"
 
 namespace btree::volume {
+    template <typename K, typename V, typename Engine = engine::DefaultEngine>
+    class Volume;
+
     template <typename K, typename V>
-    class Volume final {
+    class Volume<K, V, engine::BTreeEngine> final {
+        using EntryT = entry::Entry<K, V>;
+        using WriteBuffer = lsm::MemTable<K, V>;
+
         IOManager <K, V> io;
         BTree <K, V> btree;
+        std::unique_ptr<index::HashIndex<K>> hash_index;
+        std::unique_ptr<WriteBuffer> write_buffer;
+        const size_t write_buffer_size_in_bytes;
+        const bool read_only;
+        std::unique_ptr<ttl::Expiration<K>> expiration;
+        const double value_log_gc_ratio;
     public:
         using ValueType = typename BTree<K,V>::ValueType;
         const std::string path;
 
-        explicit Volume(const std::string& path, const int16_t order) : io(path, order), btree(order, io), path(path) {}
+        explicit Volume(const std::string& path, const int16_t order, const VolumeOptions& options = VolumeOptions()) :
+            io(path, order, options.node_buffer_size, file_flags(path, options),
+               io::FileOptions{ options.io_backend, options.page_cache_size_in_bytes, options.use_io_uring,
+                                options.access_advice },
+               options.value_log_threshold_in_bytes, static_cast<int64_t>(options.value_log_segment_size_in_bytes),
+               options.value_compression_threshold_in_bytes),
+            btree(options.node_buffer_size, io),
+            write_buffer(options.write_buffer_size_in_bytes > 0 ? std::make_unique<WriteBuffer>() : nullptr),
+            write_buffer_size_in_bytes(options.write_buffer_size_in_bytes),
+            read_only(options.read_only),
+            value_log_gc_ratio(options.value_log_gc_ratio),
+            path(path)
+        {
+            open_hash_index(options.use_hash_index);
+            open_expiration(options);
+        }
+
+        ~Volume() {
+            flush_write_buffer();
+            if (hash_index)
+                hash_index->close(io.get_file_pos_end());
+            if (expiration)
+                expiration->index().close(io.get_file_pos_end());
+        }
 
         bool exist(const K key) {
-            return btree.exist(io, key);
+            auto e = find(key);
+            return e.is_valid() && !expire_if_needed(e);
         }
 
         void set(const K key, const ValueType value) {
-            btree.set(io, key, value);
+            check_writable();
+            expire_cycle_if_due();
+            put(EntryT{ key, value }, 0);
         }
 
         void set(const K key, const V& value, const int32_t size) {
-            btree.set(io, key, value, size);
+            check_writable();
+            expire_cycle_if_due();
+            if (size != 0)
+                put(EntryT{ key, value, size }, 0);
+        }
+
+        /** The KEY expires after TTL, the volume has to be opened with VolumeOptions::use_ttl */
+        void set(const K key, const ValueType value, const std::chrono::milliseconds ttl) {
+            validate(expiration != nullptr, error_msg::ttl_is_disabled_msg, path);
+            check_writable();
+            expire_cycle_if_due();
+            put(EntryT{ key, value }, ttl::deadline(ttl));
         }
 
+        void set(const K key, const V& value, const int32_t size, const std::chrono::milliseconds ttl) {
+            validate(expiration != nullptr, error_msg::ttl_is_disabled_msg, path);
+            check_writable();
+            expire_cycle_if_due();
+            if (size != 0)
+                put(EntryT{ key, value, size }, ttl::deadline(ttl));
+        }
+
+        /**
+         * The blob points to the data of the volume: the mapped file (io::Backend::MMAP, valid until the next
+         * modification of the volume), the value buffers of PositionalFile (the next 1024 reads of values) or
+         * the decompressed value kept until its entry is overwritten. multi_get(...) returns the copies
+         */
         std::optional <V> get(const K key) {
-            return btree.get(io, key);
+            auto e = find(key);
+            if (expire_if_needed(e))
+                return std::nullopt;
+            return e.value();
+        }
+
+        /**
+         * Returns the values of the keys in the same order, the B-tree lookups of the batch are interleaved.
+         * The blobs are copied: the read value may be valid until the next reads only (see PositionalFile)
+         */
+        std::vector<std::optional<utils::owned_value_t<V>>> multi_get(const std::vector<K>& keys) {
+            // the values are read before the expired keys are erased: the erase can remap the file
+            const auto now = expiration ? ttl::now() : 0;
+            std::vector<std::optional<utils::owned_value_t<V>>> values(keys.size());
+            std::vector<EntryT> expired;
+            auto read_value = [&values, &expired, now](const size_t i, const EntryT& e) {
+                if (now && e.is_expired(now))
+                    expired.push_back(e);
+                else
+                    values[i] = e.owned_value();
+            };
+
+            // the hash index finds the entry in O(1) and the write buffer is in memory: nothing to interleave
+            std::vector<K> tree_keys;
+            std::vector<size_t> tree_idx;
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (hash_index || (write_buffer && write_buffer->find(keys[i]))) {
+                    read_value(i, find(keys[i]));
+                } else {
+                    tree_keys.push_back(keys[i]);
+                    tree_idx.push_back(i);
+                }
+            }
+            btree.find(io, tree_keys, [&read_value, &tree_idx](const size_t i, const EntryT& e) {
+                read_value(tree_idx[i], e);
+            });
+
+            for (const auto& e: expired)
+                expire_if_needed(e);
+            return values;
         }
 
         bool remove(const K key) {
-            return btree.remove(io, key);
+            check_writable();
+            expire_cycle_if_due();
+            if (expiration) {
+                // the expired KEY is removed as well, but it doesn't count as the existing one
+                auto e = find(key);
+                if (!e.is_valid())
+                    return false;
+                expiration->on_remove(key, e.expires_at);
+                erase(key);
+                return !e.is_expired(ttl::now());
+            }
+            return erase(key);
+        }
+
+        /**
+         * Calls fn(key, value) for every KEY in [FROM, TO] in the ascending order of keys,
+         * fn can return false to stop the scan
+         */
+        template <typename Fn>
+        void scan(const K from, const K to, Fn&& fn) {
+            flush_write_buffer();
+            const auto now = expiration ? ttl::now() : 0;
+            btree.traverse(io, from, to, [this, now, &fn](const int64_t entry_pos) {
+                auto e = io.read_entry(entry_pos);
+                if (now && e.is_expired(now))
+                    return true;
+                auto value = e.value();
+                return !value || utils::invoke_value_and_proceed(fn, e.key, *value, e.size_in_bytes);
+            });
+        }
+
+        /**
+         * Adds DELTA to the value of the KEY (0 if there is no such KEY) with one traversal of the tree,
+         * returns the old value. The value is overwritten in place, the expiration time is kept
+         */
+        template <typename U = V, enable_if_t<std::is_arithmetic_v<U>> = true>
+        V fetch_add(const K key, const V delta) {
+            V old_value = 0;
+            modify(key, [&old_value, delta](const std::optional<V>& old) {
+                old_value = old.value_or(0);
+                return std::optional<V>(static_cast<V>(old_value + delta));
+            });
+            return old_value;
+        }
+
+        /** Sets DESIRED if the value of the KEY equals EXPECTED, returns false otherwise */
+        template <typename U = V, enable_if_t<!std::is_pointer_v<U>> = true>
+        bool compare_exchange(const K key, const ValueType expected, const ValueType desired) {
+            return modify(key, [&expected, &desired](const std::optional<V>& old) {
+                return (old && *old == expected) ? std::optional<V>(desired) : std::nullopt;
+            });
+        }
+
+        /** Sets the VALUE, returns the old value of the KEY */
+        template <typename U = V, enable_if_t<!std::is_pointer_v<U>> = true>
+        std::optional<V> exchange(const K key, const ValueType value) {
+            std::optional<V> old_value;
+            modify(key, [&old_value, &value](const std::optional<V>& old) {
+                old_value = old;
+                return std::optional<V>(value);
+            });
+            return old_value;
+        }
+
+        /** Sets fn(value) as the value of the existing KEY, returns false if there is no such KEY */
+        template <typename Fn, typename U = V, enable_if_t<!std::is_pointer_v<U>> = true>
+        bool update(const K key, Fn&& fn) {
+            return modify(key, [&fn](const std::optional<V>& old) {
+                return old ? std::optional<V>(fn(*old)) : std::nullopt;
+            });
+        }
+
+        /** Changes the access advice of the volume file, see VolumeOptions::access_advice */
+        void advise(const io::Advice advice) {
+            io.advise(advice);
+        }
+
+        /** Removes a part of the expired keys within the CPU budget, returns the number of removed keys */
+        int64_t expire_cycle() {
+            if (!expiration || read_only)
+                return 0;
+            return expiration->run_cycle([this](const K key, const int64_t expires_at) {
+                // the KEY could be removed or set again after the record was added to the index
+                auto e = find(key);
+                return e.is_valid() && e.expires_at == expires_at && erase(key);
+            });
+        }
+
+        /**
+         * Collects the sealed segments of the value log with enough garbage (see VolumeOptions::value_log_gc_ratio),
+         * returns the number of removed segments
+         */
+        int64_t collect_value_log_garbage() {
+            auto* value_log = io.get_value_log();
+            if (!value_log || read_only)
+                return 0;
+
+            int64_t removed = 0;
+            for (auto segment: value_log->sealed_segments())
+                removed += collect_value_log_segment(segment);
+            return removed;
+        }
+
+    private:
+        /**
+         * Read-modify-write of the KEY: fn(value) gets the value (nullopt if there is no such KEY or it's expired)
+         * and returns the new value or nullopt to keep the old one. Returns true if the new value is set.
+         * The KEY found by the tree (or the hash index) is modified without the second lookup
+         */
+        template <typename Fn>
+        bool modify(const K key, Fn&& fn) {
+            check_writable();
+            expire_cycle_if_due();
+
+            // the new entry refers to the value, it lives until the entry is written
+            std::optional<V> value;
+            auto new_entry = [this, key, &value, &fn](const EntryT& old) -> std::optional<EntryT> {
+                const bool exists = old.is_valid() && !(expiration && old.is_expired(ttl::now()));
+                value = fn(exists ? old.value() : std::nullopt);
+                if (!value)
+                    return std::nullopt;
+                // the expired KEY gets the value without TTL, so its record is erased
+                if (old.is_valid() && !exists)
+                    expiration->on_remove(key, old.expires_at);
+                EntryT e{ key, *value };
+                return EntryT(key, e.data, e.size_in_bytes, exists ? old.expires_at : 0);
+            };
+
+            if (write_buffer) {
+                auto e = new_entry(find(key));
+                if (e)
+                    buffer(*e);
+                return e.has_value();
+            }
+            if (hash_index) {
+                auto entry_pos = hash_index->find(key);
+                const bool exists = entry_pos != IOManager<K, V>::INVALID_POS;
+                auto e = new_entry(exists ? io.read_entry(entry_pos) : EntryT{});
+                if (!e)
+                    return false;
+                // the leaf with the copy of the entry is found by the tree
+                if (!exists || io.has_inline_entries()) {
+                    update_hash_index(key, btree.set(io, *e));
+                } else if (auto new_pos = io.overwrite_or_write_entry(*e, entry_pos); new_pos != entry_pos) {
+                    btree.set_entry_pos(io, key, new_pos);
+                    update_hash_index(key, new_pos);
+                }
+            } else {
+                btree.update(io, key, new_entry);
+            }
+            collect_value_log_garbage_if_due();
+            return value.has_value();
+        }
+
+    private:
+        void put(const EntryT& e, const int64_t expires_at) {
+            if (expiration) {
+                // the record of the overwritten KEY is replaced
+                auto old = find(e.key);
+                if (old.is_valid())
+                    expiration->on_remove(e.key, old.expires_at);
+                expiration->on_set(e.key, expires_at);
+            }
+
+            EntryT entry(e.key, e.data, e.size_in_bytes, expires_at);
+            if (write_buffer)
+                buffer(entry);
+            else
+                update_hash_index(e.key, btree.set(io, entry));
+            collect_value_log_garbage_if_due();
+        }
+
+        /** Returns the invalid entry if there is no such KEY, the expired entries are returned as is */
+        EntryT find(const K key) {
+            if (write_buffer) {
+                if (auto* record = write_buffer->find(key))
+                    return WriteBuffer::to_entry(key, *record);
+            }
+            if (hash_index) {
+                auto entry_pos = hash_index->find(key);
+                if (entry_pos == IOManager<K, V>::INVALID_POS)
+                    return EntryT{};
+                return io.read_entry(entry_pos);
+            }
+            return btree.find(io, key);
+        }
+
+        /** Removes the KEY regardless of its expiration time */
+        bool erase(const K key) {
+            if (write_buffer) {
+                if (!find(key).is_valid())
+                    return false;
+                write_buffer->remove(key);
+                flush_write_buffer_if_full();
+                return true;
+            }
+            return remove_from_tree(key);
+        }
+
+        /** Lazy expiration: the expired entry is removed on access (unless the volume is read-only) */
+        bool expire_if_needed(const EntryT& e) {
+            if (!expiration || !e.is_expired(ttl::now()))
+                return false;
+            if (!read_only) {
+                expiration->on_remove(e.key, e.expires_at);
+                erase(e.key);
+            }
+            return true;
+        }
+
+        void check_writable() const {
+            validate(!read_only, error_msg::read_only_volume_msg, path);
+        }
+
+        void expire_cycle_if_due() {
+            if (expiration && expiration->is_cycle_due())
+                expire_cycle();
+        }
+
+        void collect_value_log_garbage_if_due() {
+            auto* value_log = io.get_value_log();
+            if (value_log && value_log->is_gc_due())
+                collect_value_log_segment(value_log->next_gc_segment());
+        }
+
+        /** The record of the segment is live if the entry of its KEY still refers to it */
+        bool collect_value_log_segment(const int64_t segment) {
+            if constexpr(std::is_arithmetic_v<V>) {
+                return false;
+            } else {
+                auto& value_log = *io.get_value_log();
+                if (segment < 0)
+                    return false;
+
+                // the buffered values aren't in the log yet, the entries of the tree refer to the records
+                flush_write_buffer();
+                std::vector<K> keys;
+                std::vector<int64_t> record_pos;
+                std::vector<int32_t> record_size;
+                value_log.for_each_record(segment, [&](const K key, const int64_t pos, const int32_t size) {
+                    keys.push_back(key);
+                    record_pos.push_back(pos);
+                    record_size.push_back(size);
+                });
+
+                auto entry_pos = find_entry_pos(keys);
+                std::vector<size_t> live;
+                int64_t live_size = 0;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    if (entry_pos[i] != IOManager<K, V>::INVALID_POS && io.read_value_pos(entry_pos[i]) == record_pos[i]) {
+                        live.push_back(i);
+                        live_size += sizeof(K) + sizeof(int32_t) + record_size[i];
+                    }
+                }
+                if (live_size > (1 - value_log_gc_ratio) * value_log.size_in_bytes(segment))
+                    return false;
+
+                // the entries are changed in place: the tree and the hash index keep the same entry positions
+                for (auto i: live)
+                    io.write_value_pos(entry_pos[i], value_log.move(record_pos[i]));
+                value_log.remove_segment(segment);
+                return true;
+            }
+        }
+
+        std::vector<int64_t> find_entry_pos(const std::vector<K>& keys) {
+            if (!hash_index)
+                return btree.find_entry_pos(io, keys);
+
+            std::vector<int64_t> entry_pos;
+            entry_pos.reserve(keys.size());
+            for (auto key: keys)
+                entry_pos.push_back(hash_index->find(key));
+            return entry_pos;
+        }
+
+        void buffer(const EntryT& e) {
+            write_buffer->set(e);
+            flush_write_buffer_if_full();
+        }
+
+        void flush_write_buffer_if_full() {
+            if (write_buffer->size_in_bytes() >= write_buffer_size_in_bytes)
+                flush_write_buffer();
+        }
+
+        void flush_write_buffer() {
+            if (!write_buffer || write_buffer->empty())
+                return;
+
+            // the ascending order of keys makes the consecutive modifications go through the same nodes
+            for (const auto& [key, record]: *write_buffer) {
+                if (record.is_removed)
+                    remove_from_tree(key);
+                else
+                    update_hash_index(key, btree.set(io, WriteBuffer::to_entry(key, record)));
+            }
+            write_buffer->clear();
+        }
+
+        bool remove_from_tree(const K key) {
+            bool success = btree.remove(io, key);
+            if (success && hash_index)
+                hash_index->erase(key);
+            return success;
+        }
+
+        void open_hash_index(const bool use_hash_index) {
+            const auto& index_path = path + ".idx";
+            if (!use_hash_index) {
+                // the volume is going to be modified without the index, so the index becomes stale
+                std::error_code ec;
+                std::filesystem::remove(index_path, ec);
+                return;
+            }
+
+            hash_index = std::make_unique<index::HashIndex<K>>(index_path);
+            if (!hash_index->is_synced_with(io.get_file_pos_end())) {
+                // the index is new or the process didn't close the volume: rebuild the index from the tree
+                hash_index->clear();
+                io.advise(0, io.get_file_pos_end(), io::Advice::WILLNEED);
+                btree.traverse(io, [this](const int64_t entry_pos) {
+                    hash_index->insert_or_assign(io.read_key(entry_pos), entry_pos);
+                });
+            }
+            hash_index->open();
+        }
+
+        void open_expiration(const VolumeOptions& options) {
+            if (!options.use_ttl)
+                return;
+
+            expiration = std::make_unique<ttl::Expiration<K>>(path + ".exp", options.expire_cycle_period,
+                                                              options.expire_cycle_cpu_percent);
+            auto& expiry_index = expiration->index();
+            if (!expiry_index.is_synced_with(io.get_file_pos_end())) {
+                // the index is new or the process didn't close the volume: rebuild the index from the tree
+                expiry_index.clear();
+                io.advise(0, io.get_file_pos_end(), io::Advice::WILLNEED);
+                btree.traverse(io, [this](const int64_t entry_pos) {
+                    auto e = io.read_entry(entry_pos);
+                    expiration->on_set(e.key, e.expires_at);
+                });
+            }
+            expiry_index.open();
+        }
+
+        static uint8_t file_flags(const std::string& path, const VolumeOptions& options) {
+            validate(!options.inline_leaf_values || std::is_arithmetic_v<V>, error_msg::inline_leaf_values_msg, path);
+            validate(!options.compress_node_keys || options.inline_leaf_values, error_msg::compress_node_keys_msg, path);
+            return (options.use_ttl ? IOManager<K, V>::EXPIRY_FLAG : 0) |
+                   (options.huge_page_nodes ? IOManager<K, V>::NODE_FILE_FLAG : 0) |
+                   (options.separate_index_file ? IOManager<K, V>::INDEX_FILE_FLAG : 0) |
+                   (options.value_log_threshold_in_bytes > 0 && !std::is_arithmetic_v<V>
+                        ? IOManager<K, V>::VALUE_LOG_FLAG : 0) |
+                   (options.inline_leaf_values ? IOManager<K, V>::INLINE_LEAF_FLAG : 0) |
+                   (options.compact_node_pointers ? IOManager<K, V>::COMPACT_POS_FLAG : 0) |
+                   (options.compress_node_keys ? IOManager<K, V>::KEY_FRAME_FLAG : 0) |
+                   (options.value_compression_threshold_in_bytes > 0 && !std::is_arithmetic_v<V>
+                        ? IOManager<K, V>::COMPRESSION_FLAG : 0);
+        }
+
+        void update_hash_index(const K key, const int64_t entry_pos) {
+            if (hash_index && entry_pos != IOManager<K, V>::INVALID_POS)
+                hash_index->insert_or_assign(key, entry_pos);
         }
     };
 
-    /** Volume with coarse-grained locks for multithreading usage */
-    template <typename K, typename V>
+    /**
+     * Volume with coarse-grained locks for multithreading usage.
+     * The volume with TTL runs the expire cycle in the background thread once per VolumeOptions::expire_cycle_period.
+     * With VolumeOptions::single_writer the mutations are applied by the single writer thread (see SingleWriter).
+     */
+    template <typename K, typename V, typename Engine = engine::DefaultEngine>
     class VolumeMT final {
-        Volume<K, V> volume;
+        Volume<K, V, Engine> volume;
         std::mutex mutex_;
+        std::unique_ptr<SingleWriter<K, V, Volume<K, V, Engine>>> writer;
+        std::condition_variable reaper_cv;
+        bool is_stopped = false;
+        std::thread reaper;
     public:
-        using ValueType = typename Volume<K,V>::ValueType;
+        using ValueType = typename Volume<K, V, Engine>::ValueType;
         const std::string path;
 
-        VolumeMT(const std::string& path, int16_t order) : volume(path, order) {}
+        VolumeMT(const std::string& path, int16_t order, const VolumeOptions& options = VolumeOptions()) :
+            volume(path, order, options), path(path)
+        {
+            if (options.single_writer && !options.read_only) {
+                writer = std::make_unique<SingleWriter<K, V, Volume<K, V, Engine>>>(
+                        volume, mutex_, options.single_writer_queue_size);
+            }
+            if constexpr(std::is_same_v<Engine, engine::BTreeEngine>) {
+                if (options.use_ttl && !options.read_only)
+                    reaper = std::thread([this, period = options.expire_cycle_period] { run_reaper(period); });
+            }
+        }
+
+        ~VolumeMT() {
+            {
+                std::scoped_lock lock(mutex_);
+                is_stopped = true;
+            }
+            reaper_cv.notify_one();
+            if (reaper.joinable())
+                reaper.join();
+            writer.reset();
+        }
 
         bool exist(const K key) {
+            wait_applied();
             std::scoped_lock lock(mutex_);
             return volume.exist(key);
         }
 
         void set(const K key, const ValueType value) {
+            if (writer)
+                return writer->set(key, value);
             std::scoped_lock lock(mutex_);
             volume.set(key, value);
         }
 
         void set(const K key, const V& value, const int32_t size) {
+            if (writer)
+                return writer->set(key, value, size);
             std::scoped_lock lock(mutex_);
             volume.set(key, value, size);
         }
 
+        void set(const K key, const ValueType value, const std::chrono::milliseconds ttl) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            volume.set(key, value, ttl);
+        }
+
+        void set(const K key, const V& value, const int32_t size, const std::chrono::milliseconds ttl) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            volume.set(key, value, size, ttl);
+        }
+
         std::optional <V> get(const K key) {
+            wait_applied();
             std::scoped_lock lock(mutex_);
             return volume.get(key);
         }
 
+        std::vector<std::optional<utils::owned_value_t<V>>> multi_get(const std::vector<K>& keys) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            return volume.multi_get(keys);
+        }
+
         bool remove(const K key) {
+            if (writer)
+                return writer->remove(key);
             std::scoped_lock lock(mutex_);
             return volume.remove(key);
         }
+
+        template <typename Fn>
+        void scan(const K from, const K to, Fn&& fn) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            volume.scan(from, to, std::forward<Fn>(fn));
+        }
+
+        template <typename U = V, enable_if_t<std::is_arithmetic_v<U>> = true>
+        V fetch_add(const K key, const V delta) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            return volume.fetch_add(key, delta);
+        }
+
+        template <typename U = V, enable_if_t<!std::is_pointer_v<U>> = true>
+        bool compare_exchange(const K key, const ValueType expected, const ValueType desired) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            return volume.compare_exchange(key, expected, desired);
+        }
+
+        template <typename U = V, enable_if_t<!std::is_pointer_v<U>> = true>
+        std::optional<V> exchange(const K key, const ValueType value) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            return volume.exchange(key, value);
+        }
+
+        template <typename Fn, typename U = V, enable_if_t<!std::is_pointer_v<U>> = true>
+        bool update(const K key, Fn&& fn) {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            return volume.update(key, std::forward<Fn>(fn));
+        }
+
+        void advise(const io::Advice advice) {
+            std::scoped_lock lock(mutex_);
+            volume.advise(advice);
+        }
+
+        int64_t collect_value_log_garbage() {
+            wait_applied();
+            std::scoped_lock lock(mutex_);
+            return volume.collect_value_log_garbage();
+        }
+
+    private:
+        /** The mutations pushed to the single writer before the query are applied first */
+        void wait_applied() {
+            if (writer)
+                writer->wait_applied();
+        }
+
+        void run_reaper(const std::chrono::milliseconds period) {
+            std::unique_lock lock(mutex_);
+            while (!reaper_cv.wait_for(lock, period, [this] { return is_stopped; }))
+                volume.expire_cycle();
+        }
     };
-}
\ No newline at end of file
+}
+
+#include "lsm/lsm_volume.h"
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "io/backend.h"
+
+namespace btree::volume {
+    /** Per-volume settings: all the optional features are disabled by default */
+    struct VolumeOptions {
+        /** set|remove throw, the expired keys are hidden but not removed. It's set by Storage::open_shared_volume */
+        bool read_only = false;
+
+        /** Keeps a persistent hash index { KEY -> entry pos } in the "<volume path>.idx" file for point queries */
+        bool use_hash_index = false;
+
+        /**
+         * B-tree engine: buffers the modifications in memory up to this limit and applies them to the tree
+         * in the ascending order of keys when the buffer is full or the volume is closed (0 disables the buffer)
+         */
+        size_t write_buffer_size_in_bytes = 0;
+
+        /**
+         * B-tree engine: internal nodes keep up to this number of pending upserts that are pushed down in batches
+         * (B^e-tree), 0 disables the node buffers. The volume has to be reopened with the same value.
+         */
+        int16_t node_buffer_size = 0;
+
+        /**
+         * B-tree engine: entries keep the expiration time, so keys can be set with TTL. The expired keys are removed
+         * on access and by the expire cycle. The volume has to be reopened with the same value.
+         */
+        bool use_ttl = false;
+
+        /**
+         * B-tree engine: the volume file is mapped to memory or read and written with pread|pwrite through
+         * the user-space page cache of page_cache_size_in_bytes, io::Backend::DIRECT bypasses the kernel page cache
+         * and allocates the nodes at the block boundaries. The file format is the same for all the backends.
+         */
+        io::Backend io_backend = io::Backend::MMAP;
+        size_t page_cache_size_in_bytes = 16 * 1024 * 1024;
+
+        /**
+         * B-tree engine with io::Backend::PREAD|DIRECT: multi_get and scan read the pages of the next nodes and entries
+         * in batches through io_uring, or through the read thread pool if it's disabled or unsupported by the kernel
+         */
+        bool use_io_uring = true;
+
+        /**
+         * B-tree engine: the expected access to the volume file, the kernel readahead follows it.
+         * io::Advice::RANDOM suits the point lookups: the page fault doesn't read the neighbour pages,
+         * the scan reads every node of several pages at once (WILLNEED of the node range)
+         */
+        io::Advice access_advice = io::Advice::NORMAL;
+
+        /**
+         * B-tree engine: the internal nodes are allocated in the separate "<volume path>.nodes" file that grows
+         * by 2 MB and is mapped with MADV_HUGEPAGE, so the upper levels of the tree take a few TLB entries.
+         * The volume has to be reopened with the same value.
+         */
+        bool huge_page_nodes = false;
+
+        /**
+         * B-tree engine: all the nodes are allocated in the "<volume path>.nodes" index file that is read ahead
+         * to stay resident, the volume file keeps only the entries. The volume has to be reopened with the same value.
+         */
+        bool separate_index_file = false;
+
+        /**
+         * B-tree engine with arithmetic values: the leaves keep the copies of their entries (KEY, EXPIRES_AT, VALUE),
+         * so get|exist end in the leaf without the random reads of the entries. The leaf with the copies takes
+         * the biggest order that fits the page of the tree (the plain node of the order), so the leaves have
+         * the smaller order than the internal nodes. The volume with the (w)string|blob values isn't opened
+         * with the option. The volume has to be reopened with the same value.
+         */
+        bool inline_leaf_values = false;
+
+        /**
+         * B-tree engine: all the nodes are allocated in the "<volume path>.nodes" index file and keep the children
+         * as the 4-byte node indexes (up to 2^32 - 1 nodes) and the entries as the 6-byte offsets (up to 256 TB)
+         * instead of 8 bytes, so the nodes take the bigger order that fits the page of the tree order and the fanout
+         * grows. The node or entry beyond the limits isn't written, the set throws. The volume has to be reopened
+         * with the same value.
+         */
+        bool compact_node_pointers = false;
+
+        /**
+         * B-tree engine with VolumeOptions::inline_leaf_values: the leaf keeps the keys of its copies as the smallest
+         * key and the deltas of 1, 2 or 4 bytes (up to half the key size) chosen per leaf, so the search in the leaf
+         * compares the packed deltas with SIMD and the leaf takes the bigger order that fits the page. The leaf
+         * of the keys that don't fit is searched and read through the entries. The volume has to be reopened with
+         * the same value.
+         */
+        bool compress_node_keys = false;
+
+        /**
+         * B-tree engine with (w)string or blob values: the values of this size in bytes or bigger are appended to
+         * the value log segments "<volume path>.vlog.<N>" and the entries keep only their positions, so the tree
+         * and the volume file don't grow with the values (WiscKey). 0 disables the value log. The volume has to be
+         * reopened with the value log enabled, the threshold can be changed.
+         */
+        int32_t value_log_threshold_in_bytes = 0;
+        size_t value_log_segment_size_in_bytes = 64 * 1024 * 1024;
+
+        /**
+         * B-tree engine with (w)string or blob values: the values of this size in bytes or bigger are compressed
+         * with zlib if they get smaller, every value of the entry is tagged with its codec (see io::Codec).
+         * The value is decompressed once and kept until its entry is overwritten, so the blob pointer of get
+         * stays valid; the memory grows with the compressed values read. 0 disables the compression. The volume has to be reopened with the compression enabled, the threshold can be changed.
+         */
+        int32_t value_compression_threshold_in_bytes = 0;
+
+        /**
+         * B-tree engine with the value log: the sealed segment is collected if this share of its bytes or more
+         * is garbage, its live values are moved to the last segment and the segment file is removed.
+         * set checks the next sealed segment every time a segment is sealed.
+         */
+        double value_log_gc_ratio = 0.5;
+
+        /** B-tree engine with TTL: the expire cycle runs at most once per this period */
+        std::chrono::milliseconds expire_cycle_period{100};
+
+        /** B-tree engine with TTL: the share of the period (in percent) that one expire cycle is allowed to take */
+        int32_t expire_cycle_cpu_percent = 25;
+
+        /**
+         * VolumeMT only: set|remove push the mutations to the lock-free queue of this size (a power of two)
+         * and the single writer thread of the volume applies them in sorted batches
+         */
+        bool single_writer = false;
+        size_t single_writer_queue_size = 8192;
+
+        /** LSM engine: the memtable is flushed to a new sorted run when it takes more memory than this limit */
+        size_t memtable_size_in_bytes = 4 * 1024 * 1024;
+
+        /** LSM engine: the background compaction merges sorted runs when there are more of them than this limit */
+        int32_t max_sorted_runs = 4;
+    };
+}
+
+namespace btree {
+    using VolumeOptions = volume::VolumeOptions;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#ifdef UNIT_TESTS
+
+#include "storage.h"
+#include "test_runner/test_value_generator.h"
+#include "utils/volume_fixture.h"
+
+namespace tests::hash_index_test {
+    constexpr std::string_view output_folder = "../../output_hash_index_test/";
+    constexpr int order = 5;
+    constexpr int elements_count = 5000;
+
+    constexpr test_utils::VolumeFixture fixture(output_folder, order);
+
+namespace details {
+    using namespace btree;
+    using namespace test_utils;
+
+    template <typename K, typename V>
+    bool run_operations(const std::string& name) {
+        const auto& path = fixture.get_file_name(name);
+        Storage<K, V> s;
+        ValueGenerator<V> g;
+
+        bool success = true;
+        {
+            auto volume = s.open_volume(path, order, with_hash_index());
+            for (int i = 0; i < elements_count; ++i)
+                key_value_op_tests::details::set(volume, i, g.next_value(i));
+            // overwrite a part of the keys with new values
+            for (int i = 0; i < elements_count; i += 7)
+                key_value_op_tests::details::set(volume, i, g.next_value(i));
+            for (int i = 0; i < elements_count; i += 3) {
+                success &= volume.remove(i);
+                g.remove(i);
+            }
+            success &= check_all(g, volume, elements_count);
+            s.close_volume(volume);
+        }
+        {
+            auto volume = s.open_volume(path, order, with_hash_index());
+            success &= check_all(g, volume, elements_count);
+            s.close_volume(volume);
+        }
+        return success;
+    }
+
+    template <typename K, typename V>
+    bool run_rebuild_after_modification_without_index(const std::string& name) {
+        const auto& path = fixture.get_file_name(name);
+        Storage<K, V> s;
+        ValueGenerator<V> g;
+
+        bool success = true;
+        {
+            auto volume = s.open_volume(path, order, with_hash_index());
+            for (int i = 0; i < elements_count; ++i)
+                key_value_op_tests::details::set(volume, i, g.next_value(i));
+            s.close_volume(volume);
+        }
+        {
+            // removes don't change the volume size, so the index must be invalidated explicitly
+            auto volume = s.open_volume(path, order);
+            for (int i = 0; i < elements_count; i += 2) {
+                success &= volume.remove(i);
+                g.remove(i);
+            }
+            s.close_volume(volume);
+        }
+        {
+            auto volume = s.open_volume(path, order, with_hash_index());
+            success &= check_all(g, volume, elements_count);
+            s.close_volume(volume);
+        }
+        return success;
+    }
+
+    template <typename K, typename V>
+    bool run_recovery_after_crash(const std::string& name) {
+        const auto& path = fixture.get_file_name(name);
+        Storage<K, V> s;
+        ValueGenerator<V> g;
+
+        bool success = true;
+        {
+            auto volume = s.open_volume(path, order, with_hash_index());
+            for (int i = 0; i < elements_count; ++i)
+                key_value_op_tests::details::set(volume, i, g.next_value(i));
+            s.close_volume(volume);
+        }
+        {
+            // emulate the process that crashed with the index opened and partially updated
+            index::HashIndex<K> crashed_index(path + ".idx");
+            crashed_index.open();
+            for (int i = 0; i < elements_count; i += 5)
+                crashed_index.erase(i);
+        }
+        {
+            auto volume = s.open_volume(path, order, with_hash_index());
+            success &= check_all(g, volume, elements_count);
+            s.close_volume(volume);
+        }
+        return success;
+    }
+}
+
+    bool test_operations() {
+        bool success = details::run_operations<int32_t, int32_t>("ops_i32");
+        success &= details::run_operations<int64_t, double>("ops_i64_d");
+        success &= details::run_operations<int32_t, std::string>("ops_str");
+        success &= details::run_operations<int32_t, const char*>("ops_blob");
+        return success;
+    }
+
+    bool test_rebuild_after_modification_without_index() {
+        bool success = details::run_rebuild_after_modification_without_index<int32_t, int32_t>("rebuild_i32");
+        success &= details::run_rebuild_after_modification_without_index<int32_t, std::wstring>("rebuild_wstr");
+        return success;
+    }
+
+    bool test_recovery_after_crash() {
+        bool success = details::run_recovery_after_crash<int32_t, int64_t>("crash_i64");
+        success &= details::run_recovery_after_crash<int64_t, std::string>("crash_str");
+        return success;
+    }
+}
+#endif // UNIT_TESTS
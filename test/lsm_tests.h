@@ -0,0 +1,138 @@
+#pragma once
+
+#ifdef UNIT_TESTS
+
+#include "storage.h"
+#include "test_runner/test_value_generator.h"
+#include "utils/volume_fixture.h"
+
+namespace tests::lsm_test {
+    constexpr std::string_view output_folder = "../../output_lsm_test/";
+    constexpr int order = 5;
+    constexpr int elements_count = 5000;
+
+    constexpr test_utils::VolumeFixture fixture(output_folder, order);
+
+namespace details {
+    using namespace btree;
+    using namespace test_utils;
+
+    template <typename V, typename VolumeT>
+    bool check_scan(ValueGenerator<V>& g, VolumeT& volume, const int from, const int to) {
+        bool success = true;
+        auto expected = g.map().lower_bound(from);
+        volume.scan(from, to, [&](const int32_t key, const V& value) {
+            success &= (expected != g.map().end()) && (expected->first == key);
+            success &= g.check_value(key, std::optional<V>(value));
+            if (expected != g.map().end())
+                ++expected;
+        });
+        return success && (expected == g.map().upper_bound(to));
+    }
+
+    template <typename K, typename V>
+    bool run_flush_and_compaction(const std::string& name) {
+        const auto& path = fixture.get_file_name(name);
+        Storage<K, V, engine::LSMEngine> s;
+        ValueGenerator<V> g;
+
+        bool success = true;
+        {
+            auto volume = s.open_volume(path, order, with_small_memtable());
+            for (int i = 0; i < elements_count; ++i)
+                key_value_op_tests::details::set(volume, i, g.next_value(i));
+            // the new values and the removed keys shadow the values in the older runs
+            for (int i = 0; i < elements_count; i += 7)
+                key_value_op_tests::details::set(volume, i, g.next_value(i));
+            for (int i = 0; i < elements_count; i += 3) {
+                success &= volume.remove(i);
+                g.remove(i);
+            }
+            success &= !volume.remove(0);
+            success &= check_all(g, volume, elements_count);
+            s.close_volume(volume);
+        }
+        {
+            auto volume = s.open_volume(path, order, with_small_memtable());
+            success &= check_all(g, volume, elements_count);
+            s.close_volume(volume);
+        }
+        return success;
+    }
+
+    template <typename K, typename V, typename Engine>
+    bool run_scan(const std::string& name) {
+        const auto& path = fixture.get_file_name(name);
+        Storage<K, V, Engine> s;
+        ValueGenerator<V> g;
+
+        auto volume = s.open_volume(path, order, with_small_memtable());
+        for (int i = 0; i < elements_count; i += 2)
+            key_value_op_tests::details::set(volume, i, g.next_value(i));
+        for (int i = 0; i < elements_count; i += 5) {
+            volume.remove(i);
+            g.remove(i);
+        }
+
+        bool success = check_scan(g, volume, 0, elements_count);
+        success &= check_scan(g, volume, 1001, 2999);
+        success &= check_scan(g, volume, 10, 10);
+        success &= check_scan(g, volume, elements_count, 2 * elements_count);
+        s.close_volume(volume);
+        return success;
+    }
+}
+
+    bool test_flush_and_compaction() {
+        bool success = details::run_flush_and_compaction<int32_t, int32_t>("compaction_i32");
+        success &= details::run_flush_and_compaction<int64_t, double>("compaction_i64_d");
+        success &= details::run_flush_and_compaction<int32_t, std::string>("compaction_str");
+        success &= details::run_flush_and_compaction<int32_t, const char*>("compaction_blob");
+        return success;
+    }
+
+    bool test_failed_compaction() {
+        const auto& path = fixture.get_file_name("failed_compaction");
+        const auto& run_path = path + ".0.run";
+        btree::Storage<int32_t, int32_t, btree::engine::LSMEngine> s;
+        auto options = test_utils::with_small_memtable();
+        options.max_sorted_runs = 4;
+
+        bool success = true;
+        {
+            auto volume = s.open_volume(path, order, options);
+            int32_t n = 0;
+            for (; !std::filesystem::exists(run_path); ++n)
+                volume.set(n, n);
+            // the compaction thread can't open the oldest run, the owner thread keeps its mapping
+            std::filesystem::rename(run_path, run_path + ".moved");
+            bool is_failed = false;
+            for (; !is_failed && n < 100000; ++n) {
+                try {
+                    volume.set(n, n);
+                } catch (const std::logic_error& e) {
+                    is_failed = std::string_view(e.what()).find("Sorted run is missing") != std::string_view::npos;
+                }
+            }
+            success &= is_failed;
+            for (int32_t i = 0; i < n - 1; ++i)
+                success &= (volume.get(i) == i);
+            std::filesystem::rename(run_path + ".moved", run_path);
+            s.close_volume(volume);
+        }
+        // the runs are as they were, the compaction is scheduled again
+        auto volume = s.open_volume(path, order, options);
+        for (int32_t i = 0; i < 100; ++i)
+            success &= (volume.get(i) == i);
+        return success;
+    }
+
+    bool test_scan() {
+        bool success = details::run_scan<int32_t, int32_t, engine::LSMEngine>("scan_lsm_i32");
+        success &= details::run_scan<int32_t, std::wstring, engine::LSMEngine>("scan_lsm_wstr");
+        success &= details::run_scan<int32_t, int32_t, engine::BTreeEngine>("scan_btree_i32");
+        success &= details::run_scan<int32_t, std::wstring, engine::BTreeEngine>("scan_btree_wstr");
+        return success;
+    }
+}
+#endif // UNIT_TESTS
@@ -3,6 +3,8 @@
 #ifdef UNIT_TESTS
 
 #include "io/mapped_file.h"
+#include "io/batch_reader.h"
+#include "io/page_cache.h"
 
 namespace tests::mapped_file_test {
     constexpr std::string_view output_folder = "../../output_mapped_file_test/";
@@ -170,5 +172,72 @@ namespace details {
         }
         return success;
     }
+
+    /** The batch is read through io_uring (if the kernel allows it) and through the read pool */
+    bool run_test_batch_reader() {
+        const auto& path = details::get_absolute_file_name("batch_reader");
+        const int64_t file_size = 1024 * 1024 + 123;
+        std::vector<uint8_t> expected(file_size);
+        for (int64_t i = 0; i < file_size; ++i)
+            expected[i] = static_cast<uint8_t>(i * 31 + i / 4096);
+
+        btree::io::FileHandle file(path);
+        file.write(0, expected.data(), file_size);
+
+        bool success = true;
+        for (bool use_io_uring: { true, false }) {
+            btree::io::BatchReader reader(use_io_uring);
+            std::vector<std::vector<uint8_t>> buffers(300);
+            std::vector<btree::io::ReadRequest> requests;
+            for (int64_t i = 0; i < 300; ++i) {
+                // the last requests cross the end of the file
+                int64_t pos = (i * 7919 * 13) % file_size;
+                buffers[i].assign(1 + (i * 37) % 9000, 0xff);
+                requests.push_back(btree::io::ReadRequest{ pos, buffers[i].data(), static_cast<int64_t>(buffers[i].size()) });
+            }
+            reader.read(file, requests);
+            for (size_t i = 0; i < requests.size(); ++i) {
+                for (int64_t j = 0; j < requests[i].size; ++j) {
+                    auto pos = requests[i].pos + j;
+                    success &= (buffers[i][j] == (pos < file_size ? expected[pos] : 0));
+                }
+            }
+        }
+        return success;
+    }
+
+    /** The pages of the internal nodes outlive the scan of the other pages, the direct file reads what was written */
+    bool run_test_page_cache_priority() {
+        const auto& path = details::get_absolute_file_name("page_cache_priority");
+        const int64_t page_size = btree::io::PageCache::page_size;
+        const int64_t page_count = 32;
+
+        bool success = true;
+        {
+            btree::io::FileHandle file(path, true);
+            btree::io::PageCache cache(file, 4 * page_size);
+            std::vector<uint8_t> page(page_size);
+            for (int64_t id = 0; id < page_count; ++id) {
+                std::fill(page.begin(), page.end(), static_cast<uint8_t>(id));
+                cache.write(id * page_size, page.data(), page_size);
+            }
+            cache.read(0, page.data(), 1);
+            cache.keep_hot(0, 1);
+            for (int64_t id = 1; id < page_count; ++id) {
+                cache.read(id * page_size + 5, page.data(), 10);
+                success &= (page[0] == id) && (page[9] == id);
+            }
+            success &= cache.is_cached(0) && !cache.is_cached(page_size);
+            cache.flush();
+            file.truncate(page_count * page_size - 100);
+        }
+
+        btree::io::FileHandle file(path);
+        std::vector<uint8_t> data(page_count * page_size, 0xff);
+        file.read(0, data.data(), page_count * page_size);
+        for (int64_t i = 0; i < page_count * page_size; ++i)
+            success &= (data[i] == (i < page_count * page_size - 100 ? i / page_size : 0));
+        return success;
+    }
 }
 #endif
\ No newline at end of file
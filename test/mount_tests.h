@@ -0,0 +1,101 @@
+#pragma once
+
+#ifdef UNIT_TESTS
+
+#include "storage.h"
+#include "utils/volume_fixture.h"
+
+namespace tests::mount_test {
+    constexpr std::string_view output_folder = "../../output_mount_test/";
+    constexpr int order = 3;
+    constexpr int n = 1000;
+
+    constexpr test_utils::VolumeFixture fixture(output_folder, order);
+
+    bool test_priority_merge() {
+        btree::Storage<int32_t, std::string> s;
+        auto low = s.open_volume(fixture.get_file_name("low"), order);
+        auto high = s.open_volume(fixture.get_file_name("high"), order);
+        for (int i = 0; i < n; ++i) {
+            low.set(i, "low" + std::to_string(i));
+            if (i % 2 == 0)
+                high.set(i, "high" + std::to_string(i));
+        }
+        high.set(n, "high" + std::to_string(n));
+
+        s.mount("/data", low, 0);
+        auto mount = s.mount("/data/", high, 10);
+        bool success = (mount.volume_count() == 2) && (mount.path() == "/data");
+
+        // the point queries stop at the highest priority volume with the KEY
+        for (int i = 0; i <= n; ++i) {
+            auto expected = (i % 2 == 0 ? "high" : "low") + std::to_string(i);
+            success &= mount.exist(i) && (mount.get(i) == expected);
+        }
+        success &= !mount.exist(n + 1) && !mount.get(n + 1).has_value();
+
+        // the merged scan crosses several batches of every volume, the high priority keys shadow the low ones
+        int count = 0;
+        int32_t prev_key = -1;
+        mount.scan(0, n, [&](const int32_t key, const std::string& value) {
+            success &= (key == prev_key + 1) && (value == (key % 2 == 0 ? "high" : "low") + std::to_string(key));
+            prev_key = key;
+            ++count;
+        });
+        success &= (count == n + 1);
+
+        // the scan stops when fn returns false
+        count = 0;
+        mount.scan(10, n, [&count](const int32_t, const std::string&) { return ++count < 300; });
+        success &= (count == 300);
+
+        // set goes to the highest priority volume, remove removes the KEY from all volumes
+        mount.set(1, "new");
+        success &= (high.get(1) == "new") && (low.get(1) == "low1") && (mount.get(1) == "new");
+        success &= mount.remove(1) && !mount.exist(1) && !low.exist(1) && !mount.remove(1);
+
+        // the priority of the mounted volume can be changed
+        s.mount("/data", low, 20);
+        success &= (mount.get(0) == "low0") && (mount.volume_count() == 2);
+        return success;
+    }
+
+    bool test_mount_tree() {
+        using StorageT = btree::Storage<int64_t, int64_t>;
+        const int mount_count = 100000;
+        bool success = true;
+
+        StorageT s;
+        auto v1 = s.open_volume(fixture.get_file_name("v1"), order);
+        auto v2 = s.open_volume(fixture.get_file_name("v2"), order);
+        v1.set(1, 1);
+        v2.set(2, 2);
+
+        s.mount("a//b/./c/", v1);
+        auto mount = s.find_mount("/a/b/c");
+        success &= mount.has_value() && (mount->get(1) == 1) && !mount->exist(2);
+        success &= s.find_mount("/a/b").has_value() && (s.find_mount("/a/b")->volume_count() == 0);
+        success &= (s.find_mount("/a/b/c/d/..")->path() == "/a/b/c");
+
+        // the nodes without volumes and children are removed
+        s.mount("/a/b", v2);
+        success &= s.unmount("/a/b/c", v1) && !s.unmount("/a/b/c", v1);
+        success &= !s.find_mount("/a/b/c").has_value() && s.find_mount("/a").has_value();
+        success &= s.unmount("/a/b", v2) && !s.find_mount("/a").has_value() && !s.find_mount("/").has_value();
+
+        for (int i = 0; i < mount_count; ++i)
+            s.mount("/mounts/" + std::to_string(i / 100) + "/" + std::to_string(i), (i % 2) ? v1 : v2, i);
+        for (int i = 0; i < mount_count; ++i) {
+            auto m = s.find_mount("/mounts/" + std::to_string(i / 100) + "/" + std::to_string(i));
+            success &= m.has_value() && m->exist(2 - i % 2);
+        }
+
+        // the closed volume is unmounted from all the nodes
+        s.close_volume(v1);
+        success &= !s.find_mount("/mounts/0/1").has_value() && s.find_mount("/mounts/0/0").has_value();
+        s.close_volume(v2);
+        success &= !s.find_mount("/mounts").has_value();
+        return success;
+    }
+}
+#endif // UNIT_TESTS
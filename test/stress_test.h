@@ -177,5 +177,34 @@ namespace details {
         return run<int, V>(type_name);
     }
 
+    /** The file size against GET latency of the raw values and the values compressed above the threshold */
+    template <typename V>
+    bool run_compression(const std::string& type_name, const int32_t threshold_in_bytes) {
+        cout << "Run compression benchmark for type " << type_name << " on " << elements_count << " elements" << endl;
+        const int32_t optimal_order = details::get_optimal_tree_order(m_boost::bip::mapped_region::get_page_size());
+
+        bool success = true;
+        std::uintmax_t file_sizes[2] = {};
+        for (int compressed = 0; compressed < 2; ++compressed) {
+            btree::VolumeOptions options;
+            options.value_compression_threshold_in_bytes = compressed ? threshold_in_bytes : 0;
+            const auto& path = details::get_file_name(type_name + (compressed ? "_zlib" : "_raw"), optimal_order);
+            btree::Storage<int, V> s;
+            {
+                auto v = s.open_volume(path, optimal_order, options);
+                cout << "\tstat for volume " << fs::canonical(v.path()) << endl;
+                details::run_set<int, V>(v);
+                s.close_volume(v);
+            }
+            file_sizes[compressed] = fs::file_size(path);
+            auto v = s.open_volume(path, optimal_order, options);
+            success &= details::run_get<int, V>(v);
+            cout << "\t\tfile size: " << details::HRFSize::size(path) << endl;
+        }
+        cout << "\tcompression ratio (threshold is " << threshold_in_bytes << " bytes): "
+             << static_cast<double>(file_sizes[0]) / static_cast<double>(file_sizes[1]) << endl;
+        return success;
+    }
+
 }
 #endif // UNIT_TESTS
\ No newline at end of file
@@ -2,16 +2,27 @@
 
 #include "utils/boost_fixture.h"
 #include "key_value_operations_tests.h"
+// the build with DEFAULT_LSM_ENGINE runs the key-value suites against the LSM engine, the rest is about the B-tree
+#ifndef DEFAULT_LSM_ENGINE
 #include "mapped_file_tests.h"
 #include "volume_tests.h"
+#include "hash_index_tests.h"
+#include "lsm_tests.h"
+#include "mount_tests.h"
 #include "stress_test.h"
+#endif
 
 namespace tests {
+#ifndef DEFAULT_LSM_ENGINE
 BOOST_AUTO_TEST_SUITE(mapped_file_test, *CleanBeforeTest(output_folder.data()))
     BOOST_AUTO_TEST_CASE(test_arithmetics_values) { BOOST_REQUIRE_MESSAGE(run_arithmetic_test(), "TEST_ARITHMETICS"); }
     BOOST_AUTO_TEST_CASE(test_strings_values) { BOOST_REQUIRE_MESSAGE(run_string_test(), "TEST_STRING"); }
     BOOST_AUTO_TEST_CASE(test_mody_and_save) { BOOST_REQUIRE_MESSAGE(run_test_modify_and_save(), "TEST_MODIFY_AND_SAVE"); }
     BOOST_AUTO_TEST_CASE(test_array) { BOOST_REQUIRE_MESSAGE(run_test_array(), "TEST_ARRAY"); }
+    BOOST_AUTO_TEST_CASE(test_batch_reader) { BOOST_REQUIRE_MESSAGE(run_test_batch_reader(), "TEST_BATCH_READER"); }
+    BOOST_AUTO_TEST_CASE(test_page_cache_priority) {
+        BOOST_REQUIRE_MESSAGE(run_test_page_cache_priority(), "TEST_PAGE_CACHE_PRIORITY");
+    }
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -23,9 +34,71 @@ BOOST_AUTO_TEST_SUITE(volume_test, *CleanBeforeTest(output_folder.data()))
     BOOST_AUTO_TEST_CASE(volume_is_not_shared_between_storages) {
         BOOST_REQUIRE_MESSAGE(test_volume_is_not_shared(), "TEST_VOLUME_IS_NOT_SHARED_BETWEEN_STORAGES");
     }
+    BOOST_AUTO_TEST_CASE(volume_path_registry) { BOOST_REQUIRE_MESSAGE(test_volume_path_registry(), "TEST_VOLUME_PATH_REGISTRY"); }
+    BOOST_AUTO_TEST_CASE(volume_shared) { BOOST_REQUIRE_MESSAGE(test_volume_shared(), "TEST_VOLUME_SHARED"); }
+    BOOST_AUTO_TEST_CASE(volume_async) { BOOST_REQUIRE_MESSAGE(test_volume_async(), "TEST_VOLUME_ASYNC"); }
+    BOOST_AUTO_TEST_CASE(volume_pread_backend) { BOOST_REQUIRE_MESSAGE(test_volume_pread_backend(), "TEST_VOLUME_PREAD_BACKEND"); }
+    BOOST_AUTO_TEST_CASE(volume_batched_reads) { BOOST_REQUIRE_MESSAGE(test_volume_batched_reads(), "TEST_VOLUME_BATCHED_READS"); }
+    BOOST_AUTO_TEST_CASE(volume_direct_backend) { BOOST_REQUIRE_MESSAGE(test_volume_direct_backend(), "TEST_VOLUME_DIRECT_BACKEND"); }
+    BOOST_AUTO_TEST_CASE(volume_access_advice) { BOOST_REQUIRE_MESSAGE(test_volume_access_advice(), "TEST_VOLUME_ACCESS_ADVICE"); }
+    BOOST_AUTO_TEST_CASE(volume_huge_page_nodes) { BOOST_REQUIRE_MESSAGE(test_volume_huge_page_nodes(), "TEST_VOLUME_HUGE_PAGE_NODES"); }
+    BOOST_AUTO_TEST_CASE(volume_separate_index_file) {
+        BOOST_REQUIRE_MESSAGE(test_volume_separate_index_file(), "TEST_VOLUME_SEPARATE_INDEX_FILE");
+    }
+    BOOST_AUTO_TEST_CASE(volume_value_log) { BOOST_REQUIRE_MESSAGE(test_volume_value_log(), "TEST_VOLUME_VALUE_LOG"); }
+    BOOST_AUTO_TEST_CASE(volume_in_place_overwrite) {
+        BOOST_REQUIRE_MESSAGE(test_volume_in_place_overwrite(), "TEST_VOLUME_IN_PLACE_OVERWRITE");
+    }
+    BOOST_AUTO_TEST_CASE(volume_read_modify_write) {
+        BOOST_REQUIRE_MESSAGE(test_volume_read_modify_write(), "TEST_VOLUME_READ_MODIFY_WRITE");
+    }
+    BOOST_AUTO_TEST_CASE(volume_inline_leaf_values) {
+        BOOST_REQUIRE_MESSAGE(test_volume_inline_leaf_values(), "TEST_VOLUME_INLINE_LEAF_VALUES");
+    }
+    BOOST_AUTO_TEST_CASE(volume_compact_node_pointers) {
+        BOOST_REQUIRE_MESSAGE(test_volume_compact_node_pointers(), "TEST_VOLUME_COMPACT_NODE_POINTERS");
+    }
+    BOOST_AUTO_TEST_CASE(volume_compressed_node_keys) {
+        BOOST_REQUIRE_MESSAGE(test_volume_compressed_node_keys(), "TEST_VOLUME_COMPRESSED_NODE_KEYS");
+    }
+    BOOST_AUTO_TEST_CASE(volume_value_compression) {
+        BOOST_REQUIRE_MESSAGE(test_volume_value_compression(), "TEST_VOLUME_VALUE_COMPRESSION");
+    }
+    BOOST_AUTO_TEST_CASE(volume_multi_get) { BOOST_REQUIRE_MESSAGE(test_volume_multi_get(), "TEST_VOLUME_MULTI_GET"); }
+    BOOST_AUTO_TEST_CASE(volume_single_writer) { BOOST_REQUIRE_MESSAGE(test_volume_single_writer(), "TEST_VOLUME_SINGLE_WRITER"); }
+    BOOST_AUTO_TEST_CASE(volume_write_buffer) { BOOST_REQUIRE_MESSAGE(test_volume_write_buffer(), "TEST_VOLUME_WRITE_BUFFER"); }
+    BOOST_AUTO_TEST_CASE(volume_node_buffers) { BOOST_REQUIRE_MESSAGE(test_volume_node_buffers(), "TEST_VOLUME_NODE_BUFFERS"); }
+    BOOST_AUTO_TEST_CASE(volume_ttl) { BOOST_REQUIRE_MESSAGE(test_volume_ttl(), "TEST_VOLUME_TTL"); }
+    BOOST_AUTO_TEST_CASE(volume_expiry_index) { BOOST_REQUIRE_MESSAGE(test_volume_expiry_index(), "TEST_VOLUME_EXPIRY_INDEX"); }
+    BOOST_AUTO_TEST_CASE(volume_mt_ttl) { BOOST_REQUIRE_MESSAGE(test_volume_mt_ttl(), "TEST_VOLUME_MT_TTL"); }
 BOOST_AUTO_TEST_SUITE_END()
 
 
+BOOST_AUTO_TEST_SUITE(hash_index_test, *CleanBeforeTest(output_folder.data()))
+    BOOST_AUTO_TEST_CASE(operations) { BOOST_REQUIRE_MESSAGE(test_operations(), "TEST_HASH_INDEX_OPERATIONS"); }
+    BOOST_AUTO_TEST_CASE(rebuild_after_modification_without_index) {
+        BOOST_REQUIRE_MESSAGE(test_rebuild_after_modification_without_index(), "TEST_HASH_INDEX_REBUILD");
+    }
+    BOOST_AUTO_TEST_CASE(recovery_after_crash) {
+        BOOST_REQUIRE_MESSAGE(test_recovery_after_crash(), "TEST_HASH_INDEX_RECOVERY");
+    }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+BOOST_AUTO_TEST_SUITE(lsm_test, *CleanBeforeTest(output_folder.data()))
+    BOOST_AUTO_TEST_CASE(flush_and_compaction) { BOOST_REQUIRE_MESSAGE(test_flush_and_compaction(), "TEST_LSM_COMPACTION"); }
+    BOOST_AUTO_TEST_CASE(failed_compaction) { BOOST_REQUIRE_MESSAGE(test_failed_compaction(), "TEST_LSM_FAILED_COMPACTION"); }
+    BOOST_AUTO_TEST_CASE(scan) { BOOST_REQUIRE_MESSAGE(test_scan(), "TEST_SCAN"); }
+BOOST_AUTO_TEST_SUITE_END()
+
+
+BOOST_AUTO_TEST_SUITE(mount_test, *CleanBeforeTest(output_folder.data()))
+    BOOST_AUTO_TEST_CASE(priority_merge) { BOOST_REQUIRE_MESSAGE(test_priority_merge(), "TEST_MOUNT_PRIORITY_MERGE"); }
+    BOOST_AUTO_TEST_CASE(mount_tree) { BOOST_REQUIRE_MESSAGE(test_mount_tree(), "TEST_MOUNT_TREE"); }
+BOOST_AUTO_TEST_SUITE_END()
+#endif
+
+
 BOOST_AUTO_TEST_SUITE(key_value_op_tests, *CleanBeforeTest(output_folder.data()))
     BOOST_DATA_TEST_CASE(test_empty_file, boost::make_iterator_range(orders), order) {
         BOOST_REQUIRE_MESSAGE(run<TestEmptyFile>("empty", order), "TEST_EMPTY_FILE");
@@ -54,6 +127,7 @@ BOOST_AUTO_TEST_SUITE(key_value_op_tests, *CleanBeforeTest(output_folder.data())
 BOOST_AUTO_TEST_SUITE_END()
 
 
+#ifndef DEFAULT_LSM_ENGINE
 BOOST_AUTO_TEST_SUITE(stress_test, *CleanBeforeTest(output_folder.data()))
     BOOST_AUTO_TEST_CASE(optimal_tree_order) { get_optimal_tree_order(); }
     BOOST_AUTO_TEST_CASE(i32) { BOOST_REQUIRE_MESSAGE(run<int32_t>("i32"), "TEST_STRESS_INT32"); }
@@ -61,7 +135,14 @@ BOOST_AUTO_TEST_SUITE(stress_test, *CleanBeforeTest(output_folder.data()))
     BOOST_AUTO_TEST_CASE(str) { BOOST_REQUIRE_MESSAGE(run<std::string>("str"), "TEST_STRESS_STRING"); }
     BOOST_AUTO_TEST_CASE(wstr) { BOOST_REQUIRE_MESSAGE(run<std::wstring>("wstr"), "TEST_STRESS_WSTRING"); }
     BOOST_AUTO_TEST_CASE(blob) { BOOST_REQUIRE_MESSAGE(run<const char*>("blob"), "TEST_STRESS_BLOB"); }
+    BOOST_AUTO_TEST_CASE(str_compression) {
+        BOOST_REQUIRE_MESSAGE(run_compression<std::string>("str_compression", 64), "TEST_STRESS_STRING_COMPRESSION");
+    }
+    BOOST_AUTO_TEST_CASE(blob_compression) {
+        BOOST_REQUIRE_MESSAGE(run_compression<const char*>("blob_compression", 64), "TEST_STRESS_BLOB_COMPRESSION");
+    }
 BOOST_AUTO_TEST_SUITE_END()
+#endif
 }
 #else
 
@@ -3,11 +3,12 @@
 #include "btree_impl/btree_node.h"
 #include "io/io_manager.h"
 #include "utils/utils.h"
+#include "storage.h"
 
 namespace tests {
     using namespace utils;
 
-    template <typename K, typename V>
+    template <typename K, typename V, typename Engine = btree::engine::DefaultEngine>
     struct SizeInfo {
         static constexpr int32_t header_size_in_bytes() {
             return btree::IOManager<K,V>::INITIAL_ROOT_POS_IN_HEADER;
@@ -32,4 +33,17 @@ namespace tests {
             }
         }
     };
-}
\ No newline at end of file
+
+    /** The volume file of the LSM engine is the manifest, the entries are in the files of the sorted runs */
+    template <typename K, typename V>
+    struct SizeInfo<K, V, btree::engine::LSMEngine> {
+        static constexpr int32_t header_size_in_bytes() {
+            return btree::volume::Volume<K, V, btree::engine::LSMEngine>::MANIFEST_HEADER_SIZE;
+        }
+
+        /** The single entry is in the single sorted run */
+        static constexpr int32_t file_size_in_bytes(const int t, const K key, const V& val, const int32_t value_size) {
+            return header_size_in_bytes() + sizeof(int64_t);
+        }
+    };
+}
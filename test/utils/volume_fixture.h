@@ -0,0 +1,173 @@
+#pragma once
+
+#ifdef UNIT_TESTS
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "storage.h"
+#include "test_runner/test_value_generator.h"
+#include "key_value_operations_tests.h"
+
+namespace tests::test_utils {
+    /** Options with the write buffer in front of the tree (and the hash index if USE_HASH_INDEX) on top of OPTIONS */
+    inline btree::VolumeOptions with_write_buffer(const bool use_hash_index, btree::VolumeOptions options = {}) {
+        options.write_buffer_size_in_bytes = 16 * 1024;
+        options.use_hash_index = use_hash_index;
+        return options;
+    }
+
+    inline btree::VolumeOptions with_hash_index(btree::VolumeOptions options = {}) {
+        options.use_hash_index = true;
+        return options;
+    }
+
+    inline btree::VolumeOptions with_ttl(const std::chrono::milliseconds expire_cycle_period, btree::VolumeOptions options = {}) {
+        options.use_ttl = true;
+        options.expire_cycle_period = expire_cycle_period;
+        options.expire_cycle_cpu_percent = 100;
+        return options;
+    }
+
+    inline btree::VolumeOptions with_node_buffers(const int16_t node_buffer_size, btree::VolumeOptions options = {}) {
+        options.node_buffer_size = node_buffer_size;
+        return options;
+    }
+
+    inline btree::VolumeOptions with_pread_backend(const size_t page_cache_size_in_bytes, btree::VolumeOptions options = {}) {
+        options.io_backend = btree::io::Backend::PREAD;
+        options.page_cache_size_in_bytes = page_cache_size_in_bytes;
+        return options;
+    }
+
+    inline btree::VolumeOptions with_direct_backend(const size_t page_cache_size_in_bytes, btree::VolumeOptions options = {}) {
+        options = with_pread_backend(page_cache_size_in_bytes, options);
+        options.io_backend = btree::io::Backend::DIRECT;
+        return options;
+    }
+
+    /** LSM engine: flushes the memtable every ~100 keys and compacts the runs often */
+    inline btree::VolumeOptions with_small_memtable(btree::VolumeOptions options = {}) {
+        options.memtable_size_in_bytes = 8 * 1024;
+        options.max_sorted_runs = 2;
+        return options;
+    }
+
+    /** OPTIONS without the runtime settings: the volume written with OPTIONS is opened with them as it is */
+    inline btree::VolumeOptions without_runtime_settings(const btree::VolumeOptions& options) {
+        const btree::VolumeOptions defaults;
+        btree::VolumeOptions file_options = options;
+        file_options.use_hash_index = defaults.use_hash_index;
+        file_options.write_buffer_size_in_bytes = defaults.write_buffer_size_in_bytes;
+        file_options.io_backend = defaults.io_backend;
+        file_options.page_cache_size_in_bytes = defaults.page_cache_size_in_bytes;
+        file_options.use_io_uring = defaults.use_io_uring;
+        file_options.access_advice = defaults.access_advice;
+        file_options.single_writer = defaults.single_writer;
+        return file_options;
+    }
+
+    /** Every key in [0, N) has the value of G in the VOLUME */
+    template <typename V, typename VolumeT>
+    bool check_all(ValueGenerator<V>& g, VolumeT& volume, const int n) {
+        bool success = true;
+        for (int i = 0; i < n; ++i) {
+            success &= g.check(i, volume);
+            success &= (volume.exist(i) == (g.map().count(i) != 0));
+        }
+        return success;
+    }
+
+    /** The volumes of the test suite in its output folder */
+    class VolumeFixture {
+        const std::string_view output_folder;
+        const int16_t order;
+    public:
+        constexpr VolumeFixture(const std::string_view output_folder, const int16_t order) :
+            output_folder(output_folder), order(order) {}
+
+        std::string get_file_name(const std::string& name_part) const {
+            return std::string(output_folder) + name_part + ".txt";
+        }
+
+        /**
+         * The keys are set, removed and set again with OPTIONS, then the volume is reopened without the runtime settings:
+         * the buffered modifications are flushed to the file on close
+         */
+        template <typename K, typename V>
+        bool run_buffered(const std::string& name, const btree::VolumeOptions& options) const {
+            const auto& path = get_file_name(name);
+            const int n = 3000;
+
+            btree::Storage<K, V> s;
+            ValueGenerator<V> g;
+
+            bool success = true;
+            {
+                // the keys are set in the descending order to check the sorted flush
+                auto volume = s.open_volume(path, order, options);
+                for (int i = n - 1; i >= 0; --i)
+                    key_value_op_tests::details::set(volume, i, g.next_value(i));
+                for (int i = 0; i < n; i += 3) {
+                    success &= volume.remove(i);
+                    g.remove(i);
+                }
+                success &= !volume.remove(0);
+                for (int i = 0; i < n; i += 6)
+                    key_value_op_tests::details::set(volume, i, g.next_value(i));
+                success &= check_all(g, volume, n);
+                s.close_volume(volume);
+            }
+            {
+                auto volume = s.open_volume(path, order, without_runtime_settings(options));
+                success &= check_all(g, volume, n);
+                s.close_volume(volume);
+            }
+            return success;
+        }
+
+        /**
+         * multi_get(...) returns the same values as get(...) of every KEY: the present, removed and missing keys.
+         * The blobs of the batch are compared after the whole batch is read
+         */
+        template <typename V>
+        bool run_multi_get(const std::string& name, const btree::VolumeOptions& options, const int16_t tree_order) const {
+            const int n = 20000;
+            btree::Storage<int32_t, V> s;
+            auto volume = s.open_volume(get_file_name(name), tree_order, options);
+            for (int i = 0; i < n; ++i) {
+                if constexpr(std::is_arithmetic_v<V>) {
+                    volume.set(i * 3, static_cast<V>(i));
+                } else if constexpr(std::is_pointer_v<V>) {
+                    const std::string blob(i % 7 + 1 + (i % 3) * 100, static_cast<char>('a' + i % 26));
+                    volume.set(i * 3, blob.c_str(), static_cast<int32_t>(blob.size()));
+                } else {
+                    volume.set(i * 3, V(i % 7 + 1, 'a' + i % 26));
+                }
+            }
+            for (int i = 0; i < n; i += 5)
+                volume.remove(i * 3);
+
+            std::vector<int32_t> keys;
+            for (int i = 0; i < 3 * n + 10; ++i)
+                keys.push_back((i * 7919) % (3 * n + 10));
+            auto values = volume.multi_get(keys);
+            bool success = (values.size() == keys.size());
+            for (size_t i = 0; success && i < keys.size(); ++i) {
+                auto value = volume.get(keys[i]);
+                if constexpr(std::is_pointer_v<V>) {
+                    const int j = keys[i] / 3;
+                    const auto size = static_cast<size_t>(j % 7 + 1 + (j % 3) * 100);
+                    success &= (values[i].has_value() == value.has_value());
+                    success &= !value || (*values[i] == std::string(size, static_cast<char>('a' + j % 26)));
+                } else {
+                    success &= (values[i] == value);
+                }
+            }
+            return success && volume.multi_get({}).empty();
+        }
+    };
+}
+#endif // UNIT_TESTS
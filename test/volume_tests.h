@@ -2,8 +2,12 @@
 
 #ifdef UNIT_TESTS
 
+#include <fstream>
+
 #include "storage.h"
 #include "utils/error.h"
+#include "test_runner/test_value_generator.h"
+#include "utils/volume_fixture.h"
 
 namespace tests::volume_test {
     constexpr std::string_view output_folder = "../../output_volume_test/";
@@ -11,11 +15,9 @@ namespace tests::volume_test {
     constexpr int key = 0;
     constexpr int value = 123456789;
 
-namespace details {
-    std::string get_file_name(const std::string& name_part) {
-        return output_folder.data() + name_part + ".txt";
-    }
+    constexpr test_utils::VolumeFixture fixture(output_folder, order);
 
+namespace details {
     template <typename K, typename V>
     bool open_to_fail(const std::string& path, const std::string_view& expected_err_msg) {
         try {
@@ -29,10 +31,32 @@ namespace details {
     }
 
     using StorageT = btree::Storage<int, int>;
+
+    /** The volume of the single writer test: the set of the negative value and the negative KEY throw */
+    struct FailingVolume {
+        using ValueType = int32_t;
+        std::map<int32_t, int32_t> values;
+
+        void set(const int32_t key, const int32_t value) {
+            if (value < 0)
+                throw std::runtime_error("the set failed");
+            values[key] = value;
+        }
+
+        bool exist(const int32_t key) const {
+            if (key < 0)
+                throw std::runtime_error("the read failed");
+            return values.count(key) != 0;
+        }
+
+        bool remove(const int32_t key) {
+            return values.erase(key) != 0;
+        }
+    };
 }
 
     bool test_volume_open_close() {
-        const auto& path = details::get_file_name("volume_open_close");
+        const auto& path = fixture.get_file_name("volume_open_close");
 
         details::StorageT s1;
         auto v1 = s1.open_volume(path, order);
@@ -45,7 +69,7 @@ namespace details {
     }
 
     bool test_volume_order() {
-        const auto& path = details::get_file_name("volume_order_validation");
+        const auto& path = fixture.get_file_name("volume_order_validation");
         bool success = false;
         {
             details::StorageT s;
@@ -63,7 +87,7 @@ namespace details {
     }
 
     bool test_volume_key_size() {
-        const auto& path = details::get_file_name("volume_key_size_validation");
+        const auto& path = fixture.get_file_name("volume_key_size_validation");
         bool success = false;
         {
             btree::Storage<int32_t, int32_t> s_int32;
@@ -76,7 +100,7 @@ namespace details {
     }
 
     bool test_volume_type() {
-        const auto& path = details::get_file_name("volume_value_validation");
+        const auto& path = fixture.get_file_name("volume_value_validation");
         bool success = false;
         {
             btree::Storage<int32_t, int32_t> s_int32;
@@ -96,7 +120,7 @@ namespace details {
     }
 
     bool test_volume_is_not_shared() {
-        const auto& path = details::get_file_name("volume_is_not_shared");
+        const auto& path = fixture.get_file_name("volume_is_not_shared");
         bool success = false;
         {
             details::StorageT s1;
@@ -117,5 +141,1084 @@ namespace details {
         return success;
     }
 
+    bool test_volume_path_registry() {
+        const auto& path = fixture.get_file_name("volume_path_registry");
+        const auto& alias = std::string(output_folder) + "./unknown/../volume_path_registry.txt";
+        bool success = true;
+        {
+            // the aliased path and the storage of another type can't open the opened volume
+            details::StorageT s1;
+            auto v1 = s1.open_volume(path, order);
+            success &= (s1.open_volume(alias, order).path() == v1.path());
+            success &= details::open_to_fail<int32_t, int32_t>(alias, "already opened in another storage");
+            success &= details::open_to_fail<int32_t, double>(path, "already opened in another storage");
+            s1.close_volume(v1);
+            success &= !btree::storage::PathRegistry::instance().is_acquired(
+                    btree::storage::PathRegistry::canonical_path(path));
+        }
+
+        // the storages open their volumes concurrently, VolumeMT knows its path
+        const int thread_count = 8;
+        std::vector<btree::StorageMT<int32_t, int32_t>> storages(thread_count);
+        std::vector<std::thread> threads;
+        std::atomic<int> failed = 0;
+        for (int i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&storages, &failed, i] {
+                for (int j = 0; j < 50; ++j) {
+                    const auto& volume_path = fixture.get_file_name("registry_" + std::to_string(i * 50 + j));
+                    auto volume = storages[i].open_volume(volume_path, order);
+                    volume.set(j, i);
+                    if (volume.path() != volume_path || volume.get(j) != i || !storages[i].close_volume(volume))
+                        ++failed;
+                }
+            });
+        }
+        for (auto& thread: threads)
+            thread.join();
+        return success && (failed == 0);
+    }
+
+    bool test_volume_shared() {
+        const auto& path = fixture.get_file_name("volume_shared");
+        const auto& registry_path = btree::storage::PathRegistry::canonical_path(path);
+        const int n = 1000;
+        bool success = true;
+        {
+            details::StorageT s;
+            auto volume = s.open_volume(path, order);
+            for (int i = 0; i < n; ++i)
+                volume.set(i, i);
+        }
+        {
+            // both storages use the same volume object, the storage of another type and open_volume(...) can't use it
+            details::StorageT s1, s2;
+            auto v1 = s1.open_shared_volume(path, order);
+            auto v2 = s2.open_shared_volume(path, order);
+            auto m1 = s1.mount("/reference", v1);
+            auto m2 = s2.mount("/data/reference", v2);
+            for (int i = 0; i < n; ++i)
+                success &= (v1.get(i) == i) && (m2.get(i) == i) && m1.exist(i);
+            success &= details::open_to_fail<int32_t, int32_t>(path, "already opened in another storage");
+            try {
+                btree::Storage<int32_t, double>().open_shared_volume(path, order);
+                success = false;
+            } catch (const std::logic_error& e) {
+                success &= std::string_view(e.what()).find("another type") != std::string_view::npos;
+            }
+            try {
+                v2.set(0, 1);
+                success = false;
+            } catch (const std::logic_error& e) {
+                success &= std::string_view(e.what()).find(error_msg::read_only_volume_msg) != std::string_view::npos;
+            }
+
+            // the volume is closed with the last storage
+            s1.close_volume(v1);
+            success &= (v2.get(n - 1) == n - 1) && btree::storage::PathRegistry::instance().is_acquired(registry_path);
+            s2.close_volume(v2);
+            success &= !btree::storage::PathRegistry::instance().is_acquired(registry_path);
+        }
+        details::StorageT s;
+        auto volume = s.open_volume(path, order);
+        volume.set(n, n);
+        success &= (volume.get(n) == n);
+
+        try {
+            s.open_shared_volume(fixture.get_file_name("volume_shared_missing"), order);
+            success = false;
+        } catch (const std::logic_error& e) {
+            success &= std::string_view(e.what()).find(error_msg::volume_does_not_exist_msg) != std::string_view::npos;
+        }
+        return success;
+    }
+
+    bool test_volume_async() {
+        const auto& path = fixture.get_file_name("volume_async");
+        const int n = 2000;
+        bool success = true;
+        {
+            btree::Storage<int32_t, std::string> s;
+            auto volume = s.open_volume(path, order);
+            std::vector<std::future<void>> done;
+            for (int i = 0; i < n; ++i)
+                done.push_back(volume.async_set(i, std::to_string(i)));
+            for (auto& f: done)
+                f.get();
+
+            std::vector<int32_t> keys;
+            for (int i = 0; i <= n; i += 2)
+                keys.push_back(i);
+            auto values = volume.async_multi_get(keys).get();
+            for (size_t i = 0; i < keys.size(); ++i)
+                success &= (keys[i] < n) ? (values[i] == std::to_string(keys[i])) : !values[i].has_value();
+
+            success &= volume.async_remove(0).get() && !volume.async_remove(0).get();
+            success &= !volume.async_get(0).get().has_value() && (volume.async_get(1).get() == "1");
+
+            // the volume waits for the queued operations when it's closed
+            for (int i = 0; i < n; ++i)
+                volume.async_set(i, "new" + std::to_string(i));
+            s.close_volume(volume);
+        }
+        {
+            btree::StorageMT<int32_t, std::string> s;
+            auto volume = s.open_shared_volume(path, order);
+            for (int i = 0; i < n; ++i)
+                success &= (volume.async_get(i).get() == "new" + std::to_string(i));
+
+            // the future holds the exception of the operation
+            try {
+                volume.async_set(0, "read-only").get();
+                success = false;
+            } catch (const std::logic_error& e) {
+                success &= std::string_view(e.what()).find(error_msg::read_only_volume_msg) != std::string_view::npos;
+            }
+        }
+
+        // the executor is configured before the first async operation
+        try {
+            btree::async::Executor::configure(2);
+            success = false;
+        } catch (const std::logic_error&) {}
+        return success;
+    }
+
+    bool test_volume_single_writer() {
+        const auto& path = fixture.get_file_name("volume_single_writer");
+        const int thread_count = 8;
+        const int n = 5000;
+        btree::VolumeOptions options;
+        options.single_writer = true;
+        options.single_writer_queue_size = 1024;
+        bool success = true;
+        {
+            btree::StorageMT<int32_t, std::string> s;
+            auto volume = s.open_volume(path, order, options);
+            std::vector<std::thread> threads;
+            std::atomic<int> failed = 0;
+            for (int t = 0; t < thread_count; ++t) {
+                threads.emplace_back([&volume, &failed, t] {
+                    // every thread reads its own writes, the even keys are removed
+                    for (int i = t; i < n; i += thread_count) {
+                        volume.set(i, "old");
+                        volume.set(i, std::to_string(i));
+                        if (volume.get(i) != std::to_string(i))
+                            ++failed;
+                        if (i % 2 == 0 && !volume.remove(i))
+                            ++failed;
+                    }
+                });
+            }
+            for (auto& thread: threads)
+                thread.join();
+            success &= (failed == 0);
+
+            // the sets and the removes of one KEY are applied in order
+            success &= !volume.remove(0);
+            volume.set(0, "a");
+            success &= volume.remove(0);
+            volume.set(0, "b");
+            success &= (volume.get(0) == "b");
+        }
+        {
+            btree::StorageMT<int32_t, std::string> s;
+            auto volume = s.open_volume(path, order);
+            for (int i = 1; i < n; ++i)
+                success &= (i % 2 == 0) ? !volume.exist(i) : (volume.get(i) == std::to_string(i));
+            success &= (volume.get(0) == "b");
+        }
+        {
+            // the blob is copied, the caller can reuse its buffer
+            btree::StorageMT<int64_t, const char*> s;
+            auto volume = s.open_volume(fixture.get_file_name("volume_single_writer_blob"), order, options);
+            std::string blob;
+            for (int i = 0; i < 100; ++i) {
+                blob = std::string(i + 1, static_cast<char>('a' + i % 26));
+                volume.set(i, blob.c_str(), static_cast<int32_t>(blob.size()));
+            }
+            for (int i = 0; i < 100; ++i) {
+                auto value = volume.get(i);
+                success &= value.has_value() && (std::string(*value, i + 1) == std::string(i + 1, 'a' + i % 26));
+            }
+        }
+
+        {
+            // the failed mutations don't stop the writer: the removal gets its exception, the set is rethrown once
+            details::FailingVolume failing_volume;
+            std::mutex mutex;
+            btree::volume::SingleWriter<int32_t, int32_t, details::FailingVolume> writer(failing_volume, mutex, 64);
+            writer.set(1, 1);
+            writer.set(2, -1);
+            writer.set(3, 3);
+            try {
+                writer.wait_applied();
+                success = false;
+            } catch (const std::runtime_error&) {}
+            writer.wait_applied();
+            try {
+                writer.remove(-1);
+                success = false;
+            } catch (const std::runtime_error&) {}
+            success &= writer.remove(1) && !writer.remove(2);
+            writer.set(4, 4);
+            writer.wait_applied();
+            std::scoped_lock lock(mutex);
+            success &= (failing_volume.values.size() == 2) && failing_volume.values.count(3) && failing_volume.values.count(4);
+        }
+
+        try {
+            options.single_writer_queue_size = 1000;
+            btree::StorageMT<int32_t, int32_t>().open_volume(fixture.get_file_name("volume_single_writer_i32"), order, options);
+            success = false;
+        } catch (const std::logic_error&) {}
+        return success;
+    }
+
+    bool test_volume_batched_reads() {
+        bool success = true;
+        for (bool use_io_uring: { true, false }) {
+            const auto& name = std::string("batched_reads_") + (use_io_uring ? "uring" : "pool");
+            auto options = test_utils::with_pread_backend(32 * 1024);
+            options.use_io_uring = use_io_uring;
+            success &= fixture.run_multi_get<std::string>(name, options, 16);
+
+            // the scan reads the children and the entries of every node in one batch
+            btree::Storage<int32_t, std::string> s;
+            auto volume = s.open_volume(fixture.get_file_name(name), 16, options);
+            int32_t expected_key = 0;
+            int32_t count = 0;
+            volume.scan(0, 1000000, [&](const int32_t key, const std::string& value) {
+                success &= (key % 3 == 0) && (key > expected_key || count == 0) && (volume.get(key) == value);
+                expected_key = key;
+                ++count;
+            });
+            success &= (count == 20000 - 20000 / 5);
+        }
+        return success;
+    }
+
+    bool test_volume_multi_get() {
+        bool success = fixture.run_multi_get<int32_t>("multi_get_i32", btree::VolumeOptions(), order);
+        success &= fixture.run_multi_get<double>("multi_get_d", btree::VolumeOptions(), 50);
+        success &= fixture.run_multi_get<std::string>("multi_get_str", btree::VolumeOptions(), 7);
+        success &= fixture.run_multi_get<int32_t>("multi_get_node_buffers", test_utils::with_node_buffers(4), 4);
+        success &= fixture.run_multi_get<int32_t>("multi_get_write_buffer", test_utils::with_write_buffer(false), order);
+        success &= fixture.run_multi_get<int32_t>("multi_get_hash_index", test_utils::with_write_buffer(true), order);
+
+        // the expired keys are hidden and erased
+        const auto& path = fixture.get_file_name("multi_get_ttl");
+        details::StorageT s;
+        auto volume = s.open_volume(path, order, test_utils::with_ttl(std::chrono::hours(1)));
+        for (int i = 0; i < 100; ++i)
+            volume.set(i, i, std::chrono::milliseconds(i % 2 ? 1 : 60000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto values = volume.multi_get({ 0, 1, 2, 3 });
+        success &= (values[0] == 0) && !values[1] && (values[2] == 2) && !values[3];
+        success &= !volume.remove(1) && volume.remove(0);
+        return success;
+    }
+
+    bool test_volume_pread_backend() {
+        // the small cache evicts the dirty pages, the volumes are reopened with the mapped file
+        bool success = fixture.run_buffered<int32_t, int32_t>("pread_i32", test_utils::with_pread_backend(8 * 1024));
+        success &= fixture.run_buffered<int32_t, std::string>("pread_str", test_utils::with_pread_backend(64 * 1024));
+        success &= fixture.run_buffered<int64_t, const char*>("pread_blob", test_utils::with_pread_backend(0, test_utils::with_node_buffers(4)));
+        // more values than the value buffers of the file
+        success &= fixture.run_multi_get<std::string>("pread_multi_get", test_utils::with_pread_backend(64 * 1024), 7);
+        // the batch has more blobs than the value buffers of the file
+        success &= fixture.run_multi_get<const char*>("pread_multi_get_blob", test_utils::with_pread_backend(64 * 1024), 7);
+
+        // the volume written through the mapping is read with pread, the empty tree cuts the file
+        const auto& path = fixture.get_file_name("pread_i32");
+        details::StorageT s;
+        {
+            auto volume = s.open_volume(path, order, test_utils::with_pread_backend(4096));
+            success &= volume.exist(1) && !volume.exist(3) && volume.exist(6);
+            for (int i = 0; i < 3000; ++i)
+                volume.remove(i);
+            s.close_volume(volume);
+        }
+        auto volume = s.open_volume(path, order);
+        success &= !volume.exist(1);
+        volume.set(1, 1);
+        success &= (volume.get(1) == 1);
+        return success;
+    }
+
+    bool test_volume_direct_backend() {
+        auto options = test_utils::with_direct_backend(16 * 1024);
+        bool success = fixture.run_buffered<int32_t, int32_t>("direct_i32", options);
+        success &= fixture.run_buffered<int32_t, std::string>("direct_str", options);
+        success &= fixture.run_multi_get<std::string>("direct_multi_get", options, 7);
+
+        // the root is allocated at the block boundary, the volume without the flags has the plain header
+        const auto& path = fixture.get_file_name("direct_i32");
+        std::ifstream file(path, std::ios::binary);
+        int64_t root_pos = 0;
+        file.seekg(5);
+        file.read(reinterpret_cast<char*>(&root_pos), sizeof(root_pos));
+        success &= root_pos > 0 && root_pos % btree::io::block_size == 0;
+        return success;
+    }
+
+    bool test_volume_access_advice() {
+        // the advice doesn't change the content: the remaps of the growing file keep it
+        btree::VolumeOptions options;
+        options.access_advice = btree::io::Advice::RANDOM;
+        bool success = fixture.run_buffered<int32_t, std::string>("advice_random", options);
+        success &= fixture.run_multi_get<std::string>("advice_random_multi_get", options, 50);
+        options.access_advice = btree::io::Advice::WILLNEED;
+        options.use_hash_index = true;
+        success &= fixture.run_buffered<int32_t, int32_t>("advice_willneed", options);
+        options.access_advice = btree::io::Advice::SEQUENTIAL;
+        success &= fixture.run_buffered<int32_t, int32_t>("advice_pread", test_utils::with_pread_backend(64 * 1024, options));
+
+        // the scan of the random volume reads the nodes of several pages with WILLNEED
+        btree::Storage<int32_t, std::string> s;
+        auto volume = s.open_volume(fixture.get_file_name("advice_random_multi_get"), 50);
+        volume.advise(btree::io::Advice::RANDOM);
+        int32_t count = 0;
+        volume.scan(0, 1000000, [&](const int32_t key, const std::string& value) {
+            success &= (key % 3 == 0) && (volume.get(key) == value);
+            ++count;
+        });
+        volume.advise(btree::io::Advice::SEQUENTIAL);
+        volume.scan(0, 1000000, [&](const int32_t, const std::string&) { --count; });
+        success &= (count == 0);
+        return success;
+    }
+
+    bool test_volume_huge_page_nodes() {
+        btree::VolumeOptions options;
+        options.huge_page_nodes = true;
+        bool success = fixture.run_buffered<int32_t, std::string>("huge_page_nodes_str", options);
+        success &= fixture.run_multi_get<int32_t>("huge_page_nodes_multi_get", options, 4);
+        options.node_buffer_size = 4;
+        success &= fixture.run_buffered<int32_t, int32_t>("huge_page_nodes_buffers", options);
+
+        // the root is internal, so it's in the node file
+        const auto& path = fixture.get_file_name("huge_page_nodes_multi_get");
+        {
+            std::ifstream file(path, std::ios::binary);
+            int64_t root_pos = 0;
+            file.seekg(8);
+            file.read(reinterpret_cast<char*>(&root_pos), sizeof(root_pos));
+            success &= (root_pos & btree::IOManager<int32_t, int32_t>::NODE_FILE_BIT) != 0;
+            success &= std::filesystem::file_size(path + ".nodes") > 8;
+        }
+
+        details::StorageT s;
+        try {
+            s.open_volume(path, 4);
+            success = false;
+        } catch (const std::logic_error&) {}
+
+        btree::VolumeOptions reopen_options;
+        reopen_options.huge_page_nodes = true;
+        {
+            auto volume = s.open_volume(path, 4, reopen_options);
+            for (int i = 0; i < 20000; ++i)
+                volume.remove(i * 3);
+            s.close_volume(volume);
+        }
+        // the empty tree cuts the node file as well
+        success &= std::filesystem::file_size(path + ".nodes") == 8;
+        auto volume = s.open_volume(path, 4, reopen_options);
+        volume.set(1, 1);
+        success &= (volume.get(1) == 1);
+        return success;
+    }
+
+    bool test_volume_separate_index_file() {
+        btree::VolumeOptions options;
+        options.separate_index_file = true;
+        bool success = fixture.run_buffered<int32_t, std::string>("index_file_str", options);
+        success &= fixture.run_multi_get<std::string>("index_file_multi_get", options, 7);
+        auto huge_page_options = options;
+        huge_page_options.huge_page_nodes = true;
+        success &= fixture.run_buffered<int64_t, const char*>("index_file_blob", test_utils::with_pread_backend(16 * 1024, huge_page_options));
+
+        // the volume file is the heap of the entries only
+        const auto& path = fixture.get_file_name("index_file_i32");
+        details::StorageT s;
+        {
+            auto volume = s.open_volume(path, order, options);
+            for (int i = 0; i < 1000; ++i)
+                volume.set(i, i);
+            s.close_volume(volume);
+        }
+        success &= std::filesystem::file_size(path) == 16 + 1000 * (sizeof(int32_t) + sizeof(int32_t));
+        auto volume = s.open_volume(path, order, options);
+        for (int i = 0; i < 1000; ++i)
+            success &= (volume.get(i) == i);
+        return success;
+    }
+
+    bool test_volume_value_log() {
+        btree::VolumeOptions options;
+        options.value_log_threshold_in_bytes = 64;
+        options.value_log_segment_size_in_bytes = 64 * 1024;
+        bool success = fixture.run_buffered<int32_t, std::string>("value_log_str", options);
+        success &= fixture.run_multi_get<std::string>("value_log_multi_get", options, 7);
+        success &= fixture.run_buffered<int32_t, std::wstring>("value_log_wstr", test_utils::with_write_buffer(true, options));
+        success &= fixture.run_buffered<int64_t, const char*>("value_log_blob", test_utils::with_pread_backend(16 * 1024, options));
+
+        // the big values are overwritten: set collects the sealed segments of the overwritten values
+        const auto& path = fixture.get_file_name("value_log_gc");
+        auto segment_count = [&path] {
+            const auto prefix = std::filesystem::path(path).filename().string() + ".vlog.";
+            int count = 0;
+            for (const auto& item: std::filesystem::directory_iterator(std::filesystem::path(path).parent_path()))
+                count += item.path().filename().string().rfind(prefix, 0) == 0;
+            return count;
+        };
+        btree::Storage<int32_t, std::string> s;
+        {
+            auto volume = s.open_volume(path, order, options);
+            for (int i = 100; i < 200; ++i)
+                volume.set(i, std::to_string(i));
+            for (int round = 0; round < 20; ++round) {
+                for (int i = 0; i < 100; ++i)
+                    volume.set(i, std::string(1000, static_cast<char>('a' + round)));
+            }
+            success &= std::filesystem::file_size(path) < 100 * 1000;
+            for (int i = 0; i < 100; ++i)
+                success &= (volume.get(i) == std::string(1000, 't'));
+            // 2 MB of values in the segments of 64 KB
+            success &= segment_count() < 8;
+            for (int i = 0; i < 100; ++i)
+                volume.remove(i);
+            volume.collect_value_log_garbage();
+            success &= segment_count() == 1;
+            s.close_volume(volume);
+        }
+        auto volume = s.open_volume(path, order, options);
+        for (int i = 100; i < 200; ++i)
+            success &= (volume.get(i) == std::to_string(i)) && !volume.exist(i - 100);
+        return success;
+    }
+
+    bool test_volume_in_place_overwrite() {
+        const auto& path = fixture.get_file_name("in_place_i32");
+        const auto ttl_options = test_utils::with_ttl(std::chrono::milliseconds(100));
+        bool success = true;
+        details::StorageT s;
+        {
+            auto volume = s.open_volume(path, order, ttl_options);
+            for (int i = 0; i < 1000; ++i)
+                volume.set(i, i);
+            s.close_volume(volume);
+        }
+        const auto size = std::filesystem::file_size(path);
+        {
+            // the counters don't grow the volume
+            auto volume = s.open_volume(path, order, ttl_options);
+            for (int round = 1; round <= 10; ++round) {
+                for (int i = 0; i < 1000; ++i)
+                    volume.set(i, i + round);
+            }
+            volume.set(0, 0, std::chrono::hours(1));
+            for (int i = 1; i < 1000; ++i)
+                success &= (volume.get(i) == i + 10);
+            success &= (volume.get(0) == 0);
+            s.close_volume(volume);
+        }
+        success &= std::filesystem::file_size(path) == size;
+
+        // the smaller value is written in place, the bigger one is appended
+        const auto& str_path = fixture.get_file_name("in_place_str");
+        btree::Storage<int32_t, std::string> str_s;
+        auto expected = [](const int i) {
+            return (i % 2 == 0) ? std::string(75, 'c') : std::string(50 + i / 2, 'b');
+        };
+        {
+            auto volume = str_s.open_volume(str_path, order);
+            for (int i = 0; i < 100; ++i)
+                volume.set(i, std::string(100, 'a'));
+            str_s.close_volume(volume);
+        }
+        const auto str_size = std::filesystem::file_size(str_path);
+        {
+            auto volume = str_s.open_volume(str_path, order);
+            for (int i = 0; i < 100; ++i)
+                volume.set(i, std::string(50 + i / 2, 'b'));
+            for (int i = 0; i < 100; i += 2)
+                volume.set(i, std::string(75, 'c'));
+            str_s.close_volume(volume);
+        }
+        // the values of 75 bytes don't fit in place of the values of 50 + i / 2 bytes for i < 50
+        success &= std::filesystem::file_size(str_path) == str_size + 25 * (sizeof(int32_t) + sizeof(int32_t) + 75);
+
+        auto volume = str_s.open_volume(str_path, order);
+        for (int i = 0; i < 100; ++i)
+            success &= (volume.get(i) == expected(i));
+        return success;
+    }
+
+namespace details {
+    template <typename VolumeT>
+    bool run_read_modify_write(VolumeT& volume) {
+        bool success = (volume.exchange(1, "a") == std::nullopt) && (volume.exchange(1, "bb") == "a");
+        success &= !volume.compare_exchange(1, "a", "c") && volume.compare_exchange(1, "bb", "c");
+        success &= !volume.compare_exchange(2, "", "d") && (volume.get(1) == "c");
+        success &= !volume.update(2, [](const std::string& value) { return value + "e"; });
+        for (int i = 0; i < 3; ++i)
+            success &= volume.update(1, [](const std::string& value) { return value + "e"; });
+        success &= (volume.get(1) == "ceee") && !volume.exist(2);
+        return success;
+    }
+}
+
+    bool test_volume_read_modify_write() {
+        const auto& path = fixture.get_file_name("rmw_i32");
+        bool success = true;
+        details::StorageT s;
+        {
+            auto volume = s.open_volume(path, order);
+            for (int i = 0; i < 1000; ++i)
+                success &= (volume.fetch_add(i, 1) == 0);
+            s.close_volume(volume);
+        }
+        const auto size = std::filesystem::file_size(path);
+        {
+            // the counters are incremented in place
+            auto volume = s.open_volume(path, order);
+            for (int round = 1; round < 10; ++round) {
+                for (int i = 0; i < 1000; ++i)
+                    success &= (volume.fetch_add(i, 1) == round);
+            }
+            success &= (volume.exchange(0, 100) == 10) && volume.compare_exchange(0, 100, 5);
+            success &= !volume.compare_exchange(0, 100, 6);
+            success &= volume.update(1, [](const int value) { return value * 2; }) && (volume.get(1) == 20);
+            s.close_volume(volume);
+        }
+        success &= std::filesystem::file_size(path) == size;
+        {
+            auto volume = s.open_volume(path, order);
+            success &= (volume.exchange(1000, 1) == std::nullopt) && (volume.get(1000) == 1);
+            success &= (volume.get(0) == 5) && (volume.get(999) == 10);
+            s.close_volume(volume);
+        }
+
+        btree::Storage<int32_t, std::string> str_s;
+        for (const auto& [name, options]: { std::make_pair("rmw_str", btree::VolumeOptions()),
+                                            std::make_pair("rmw_str_hash", test_utils::with_write_buffer(true)),
+                                            std::make_pair("rmw_str_buffers", test_utils::with_node_buffers(4)) }) {
+            auto options_with_index = options;
+            options_with_index.use_hash_index = true;
+            auto volume = str_s.open_volume(fixture.get_file_name(name), order, options_with_index);
+            success &= details::run_read_modify_write(volume);
+            str_s.close_volume(volume);
+        }
+
+        // the increments of the threads aren't lost
+        const int thread_count = 4;
+        const int n = 2000;
+        btree::StorageMT<int32_t, int32_t> mt_s;
+        btree::VolumeOptions options;
+        options.single_writer = true;
+        auto volume = mt_s.open_volume(fixture.get_file_name("rmw_mt"), order, options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&volume] {
+                for (int i = 0; i < n; ++i)
+                    volume.fetch_add(i % 100, 1);
+            });
+        }
+        for (auto& thread: threads)
+            thread.join();
+        for (int i = 0; i < 100; ++i)
+            success &= (volume.get(i) == thread_count * n / 100);
+        return success;
+    }
+
+    bool test_volume_inline_leaf_values() {
+        btree::VolumeOptions options;
+        options.inline_leaf_values = true;
+        bool success = fixture.run_buffered<int32_t, int32_t>("inline_i32", options);
+        success &= fixture.run_multi_get<double>("inline_multi_get", options, 7);
+        success &= fixture.run_buffered<int64_t, int64_t>("inline_node_buffers", test_utils::with_node_buffers(4, options));
+        success &= fixture.run_buffered<int32_t, float>("inline_ttl", test_utils::with_ttl(std::chrono::milliseconds(100), options));
+        success &= fixture.run_buffered<int32_t, uint64_t>("inline_pread", test_utils::with_pread_backend(16 * 1024, options));
+
+        // the counters updated in place are seen through the copies of the leaves
+        details::StorageT s;
+        const auto& path = fixture.get_file_name("inline_fetch_add");
+        {
+            auto volume = s.open_volume(path, order, options);
+            for (int round = 0; round < 5; ++round) {
+                for (int i = 0; i < 500; ++i)
+                    volume.fetch_add(i, i);
+            }
+            for (int i = 0; i < 500; ++i)
+                success &= (volume.get(i) == 5 * i);
+            s.close_volume(volume);
+        }
+
+        // the leaf with the copies fits the page of the tree: its order is smaller than the order of the internal nodes
+        {
+            const int16_t page_order = 64;
+            btree::IOManager<int32_t, int32_t> io(fixture.get_file_name("inline_order"), page_order, 0, btree::IOManager<int32_t, int32_t>::INLINE_LEAF_FLAG);
+            success &= io.order(false) == page_order && io.order(true) > 1 && io.order(true) < page_order;
+        }
+
+        // the (w)string|blob values aren't copied: the volume isn't opened with the option
+        try {
+            btree::Storage<int32_t, std::string>().open_volume(fixture.get_file_name("inline_str"), order, options);
+            success = false;
+        } catch (const std::logic_error&) {}
+
+        // the lookup ends in the leaf root: the entries aren't read
+        const auto& leaf_path = fixture.get_file_name("inline_leaf_root");
+        const int16_t leaf_order = 128;
+        options.separate_index_file = true;
+        {
+            auto volume = s.open_volume(leaf_path, leaf_order, options);
+            for (int i = 0; i < 100; ++i)
+                volume.set(i, i);
+            s.close_volume(volume);
+        }
+        {
+            std::fstream file(leaf_path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(16);
+            const std::string garbage(std::filesystem::file_size(leaf_path) - 16, '\xff');
+            file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+        auto volume = s.open_volume(leaf_path, leaf_order, options);
+        for (int i = 0; i < 100; ++i)
+            success &= (volume.get(i) == i);
+        return success && !volume.exist(100);
+    }
+
+    bool test_volume_compact_node_pointers() {
+        btree::VolumeOptions options;
+        options.compact_node_pointers = true;
+        bool success = fixture.run_buffered<int32_t, std::string>("compact_str", options);
+        success &= fixture.run_multi_get<int8_t>("compact_multi_get", options, 7);
+        auto huge_page_options = options;
+        huge_page_options.huge_page_nodes = true;
+        success &= fixture.run_buffered<int64_t, int64_t>("compact_node_buffers", test_utils::with_node_buffers(4, huge_page_options));
+        success &= fixture.run_buffered<int32_t, std::wstring>("compact_direct", test_utils::with_direct_backend(16 * 1024, options));
+        auto inline_options = options;
+        inline_options.inline_leaf_values = true;
+        success &= fixture.run_buffered<int32_t, uint8_t>("compact_pread_inline", test_utils::with_pread_backend(16 * 1024, inline_options));
+
+        // the nodes with the compact positions take the bigger order that fits the page
+        {
+            const int16_t page_order = 64;
+            btree::IOManager<int32_t, int32_t> io(fixture.get_file_name("compact_order"), page_order, 0, btree::IOManager<int32_t, int32_t>::COMPACT_POS_FLAG);
+            success &= io.order(false) > page_order && io.order(true) > page_order;
+        }
+
+        // the index file of the same tree is smaller
+        details::StorageT s;
+        auto index_file_size = [&s](const std::string& name, btree::VolumeOptions volume_options) {
+            const auto& path = fixture.get_file_name(name);
+            volume_options.separate_index_file = true;
+            {
+                auto volume = s.open_volume(path, order, volume_options);
+                for (int i = 0; i < 1000; ++i)
+                    volume.set(i, i);
+                s.close_volume(volume);
+            }
+            auto volume = s.open_volume(path, order, volume_options);
+            bool found = true;
+            for (int i = 0; i < 1000; ++i)
+                found &= (volume.get(i) == i);
+            return found ? std::filesystem::file_size(path + ".nodes") : 0;
+        };
+        const auto compact_size = index_file_size("compact_index_file", options);
+        success &= compact_size > 0 && compact_size < index_file_size("compact_index_file_plain", btree::VolumeOptions());
+
+        // the entries beyond 1 TB keep their positions (the sparse file takes no space, PREAD doesn't map it)
+        const auto& path = fixture.get_file_name("compact_1tb");
+        const auto pread_options = test_utils::with_pread_backend(16 * 1024, options);
+        {
+            auto volume = s.open_volume(path, order, pread_options);
+            for (int i = 0; i < 100; ++i)
+                volume.set(i, i);
+            s.close_volume(volume);
+        }
+        std::filesystem::resize_file(path, int64_t(1) << 40);
+        {
+            auto volume = s.open_volume(path, order, pread_options);
+            for (int i = 100; i < 200; ++i)
+                volume.set(i, i);
+            for (int i = 0; i < 200; ++i)
+                success &= (volume.get(i) == i);
+            s.close_volume(volume);
+        }
+        auto volume = s.open_volume(path, order, pread_options);
+        for (int i = 0; i < 200; ++i)
+            success &= (volume.get(i) == i);
+        success &= volume.multi_get({ 150, 50 }) == std::vector<std::optional<int>>{ 150, 50 };
+        s.close_volume(volume);
+        std::filesystem::remove(path);
+        return success;
+    }
+
+    bool test_volume_compressed_node_keys() {
+        btree::VolumeOptions options;
+        options.inline_leaf_values = true;
+        options.compress_node_keys = true;
+        bool success = fixture.run_buffered<int32_t, int32_t>("node_keys_i32", options);
+        success &= fixture.run_multi_get<double>("node_keys_multi_get", options, 7);
+        success &= fixture.run_buffered<int64_t, int64_t>("node_keys_buffers", test_utils::with_node_buffers(4, options));
+        success &= fixture.run_buffered<int32_t, float>("node_keys_ttl", test_utils::with_ttl(std::chrono::milliseconds(100), options));
+        auto compact_options = options;
+        compact_options.compact_node_pointers = true;
+        success &= fixture.run_buffered<int64_t, uint8_t>("node_keys_compact_pread", test_utils::with_pread_backend(16 * 1024, compact_options));
+
+        // the leaf without the keys of the copies takes the bigger order
+        {
+            const int16_t page_order = 64;
+            using IOManagerT = btree::IOManager<int64_t, int64_t>;
+            IOManagerT inline_io(fixture.get_file_name("node_keys_inline_order"), page_order, 0, IOManagerT::INLINE_LEAF_FLAG);
+            IOManagerT frame_io(fixture.get_file_name("node_keys_frame_order"), page_order, 0, IOManagerT::INLINE_LEAF_FLAG | IOManagerT::KEY_FRAME_FLAG);
+            success &= frame_io.order(true) > inline_io.order(true) && frame_io.order(true) < page_order;
+        }
+
+        // the keys are compressed with the inline leaf values only
+        try {
+            btree::VolumeOptions keys_only;
+            keys_only.compress_node_keys = true;
+            details::StorageT().open_volume(fixture.get_file_name("node_keys_only"), order, keys_only);
+            success = false;
+        } catch (const std::logic_error&) {}
+
+        // the packed deltas of every width give the lower bound
+        std::mt19937 gen(42);
+        auto check_count_less = [&gen](auto type_tag, const int32_t n) {
+            using T = decltype(type_tag);
+            std::vector<T> values(n);
+            for (auto& v: values)
+                v = static_cast<T>(gen() % 300);
+            std::sort(values.begin(), values.end());
+            const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+            bool found = true;
+            for (int v: {0, 1, 100, 255, 299, 300}) {
+                const auto value = static_cast<T>(v);
+                const auto expected = std::lower_bound(values.begin(), values.end(), value) - values.begin();
+                found &= utils::count_less(bytes, n, value) == expected;
+            }
+            return found;
+        };
+        for (int32_t n: {0, 1, 15, 16, 17, 63, 64, 65, 200}) {
+            success &= check_count_less(uint8_t(), n);
+            success &= check_count_less(uint16_t(), n);
+            success &= check_count_less(uint32_t(), n);
+        }
+
+        // the keys of the leaf don't fit in the deltas: the leaf is searched and read through the entries
+        {
+            btree::Storage<int64_t, int64_t> s;
+            const auto& path = fixture.get_file_name("node_keys_wide");
+            const int64_t step = int64_t(1) << 33;
+            {
+                auto volume = s.open_volume(path, order, options);
+                for (int64_t i = -500; i < 500; ++i)
+                    volume.set(i * step, i);
+                s.close_volume(volume);
+            }
+            auto volume = s.open_volume(path, order, options);
+            for (int64_t i = -500; i < 500; ++i)
+                success &= (volume.get(i * step) == i) && !volume.exist(i * step + 1);
+            s.close_volume(volume);
+        }
+
+        // the lookup ends in the leaf root: the missing keys aren't looked for in the entries
+        const auto& path = fixture.get_file_name("node_keys_leaf_root");
+        const int16_t leaf_order = 128;
+        options.separate_index_file = true;
+        details::StorageT s;
+        {
+            auto volume = s.open_volume(path, leaf_order, options);
+            for (int i = 0; i < 100; ++i)
+                volume.set(2 * i, i);
+            s.close_volume(volume);
+        }
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(16);
+            const std::string garbage(std::filesystem::file_size(path) - 16, '\xff');
+            file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+        auto volume = s.open_volume(path, leaf_order, options);
+        for (int i = 0; i < 100; ++i)
+            success &= (volume.get(2 * i) == i) && !volume.exist(2 * i + 1);
+        return success && !volume.exist(200);
+    }
+
+    bool test_volume_value_compression() {
+        btree::VolumeOptions options;
+        options.value_compression_threshold_in_bytes = 16;
+        bool success = fixture.run_buffered<int32_t, std::string>("compression_str", options);
+        success &= fixture.run_multi_get<std::string>("compression_multi_get", options, 7);
+        // every blob of the batch is decompressed to its own buffer
+        success &= fixture.run_multi_get<const char*>("compression_multi_get_blob", options, 7);
+        success &= fixture.run_multi_get<const char*>("compression_multi_get_blob_pread", test_utils::with_pread_backend(64 * 1024, options), 7);
+        auto value_log_options = options;
+        value_log_options.value_log_threshold_in_bytes = 64;
+        success &= fixture.run_buffered<int32_t, std::wstring>("compression_value_log", test_utils::with_write_buffer(true, value_log_options));
+        success &= fixture.run_buffered<int64_t, const char*>("compression_direct", test_utils::with_direct_backend(16 * 1024, options));
+
+        // the JSON documents take a fraction of the volume file without the compression
+        auto json = [](const int i) {
+            std::string doc = "{\"id\": " + std::to_string(i) + ", \"items\": [";
+            for (int j = 0; j < 20; ++j)
+                doc += "{\"name\": \"item\", \"price\": " + std::to_string(j % 7) + ", \"tags\": [\"a\", \"b\"]}, ";
+            return doc + "{}]}";
+        };
+        btree::Storage<int32_t, std::string> s;
+        auto fill = [&](const std::string& name, const btree::VolumeOptions& volume_options) {
+            const auto& path = fixture.get_file_name(name);
+            {
+                auto volume = s.open_volume(path, order, volume_options);
+                for (int i = 0; i < 500; ++i)
+                    volume.set(i, json(i));
+                s.close_volume(volume);
+            }
+            auto volume = s.open_volume(path, order, volume_options);
+            for (int i = 0; i < 500; ++i)
+                success &= (volume.get(i) == json(i));
+            // the same document fits in place of the compressed one
+            const auto size = std::filesystem::file_size(path);
+            volume.set(7, json(7));
+            success &= (volume.get(7) == json(7)) && std::filesystem::file_size(path) == size;
+            s.close_volume(volume);
+            return size;
+        };
+        const auto compressed_size = fill("compression_json", options);
+        success &= compressed_size * 4 < fill("compression_json_raw", btree::VolumeOptions());
+
+        // the short values and the incompressible ones are kept raw
+        {
+            auto volume = s.open_volume(fixture.get_file_name("compression_raw"), order, options);
+            std::string random_value(1000, 'a');
+            std::mt19937 gen(7);
+            for (auto& c: random_value)
+                c = static_cast<char>(gen());
+            volume.set(1, "short");
+            volume.set(2, random_value);
+            success &= (volume.get(1) == "short") && (volume.get(2) == random_value);
+        }
+
+        // the decompressed blob outlives the reads of the other values, the overwritten entry is decompressed again
+        {
+            btree::Storage<int32_t, const char*> blob_storage;
+            auto volume = blob_storage.open_volume(fixture.get_file_name("compression_blob_lifetime"), order,
+                                                   test_utils::with_pread_backend(64 * 1024, options));
+            const int n = 2000;
+            for (int i = 0; i < n; ++i) {
+                const auto& doc = json(i);
+                volume.set(i, doc.c_str(), static_cast<int32_t>(doc.size()));
+            }
+            const auto first = volume.get(0);
+            for (int i = 1; i < n; ++i) {
+                const auto& doc = json(i);
+                const auto value = volume.get(i);
+                success &= value.has_value() && std::string(*value, doc.size()) == doc;
+            }
+            success &= first.has_value() && std::string(*first, json(0).size()) == json(0);
+
+            auto doc = json(0);
+            doc[1] = '[';
+            volume.set(0, doc.c_str(), static_cast<int32_t>(doc.size()));
+            const auto value = volume.get(0);
+            success &= value.has_value() && std::string(*value, doc.size()) == doc;
+        }
+
+        // the codec tag is a part of the entry format
+        try {
+            s.open_volume(fixture.get_file_name("compression_json"), order);
+            success = false;
+        } catch (const std::logic_error& e) {
+            std::string_view err_msg = e.what();
+            success &= err_msg.find(error_msg::wrong_flags_msg) != std::string_view::npos;
+        }
+        return success;
+    }
+
+    bool test_volume_write_buffer() {
+        bool success = fixture.run_buffered<int32_t, int32_t>("write_buffer_i32", test_utils::with_write_buffer(false));
+        success &= fixture.run_buffered<int32_t, std::string>("write_buffer_str", test_utils::with_write_buffer(false));
+        success &= fixture.run_buffered<int64_t, const char*>("write_buffer_blob", test_utils::with_write_buffer(true));
+        return success;
+    }
+
+    bool test_volume_node_buffers() {
+        bool success = fixture.run_buffered<int32_t, int32_t>("node_buffers_i32", test_utils::with_node_buffers(1));
+        success &= fixture.run_buffered<int32_t, std::wstring>("node_buffers_wstr", test_utils::with_node_buffers(8));
+        success &= fixture.run_buffered<int64_t, double>("node_buffers_d", test_utils::with_node_buffers(64));
+
+        // the messages left in the buffers are found by the scan and the removal of the reopened volume
+        {
+            const auto& reopened_path = fixture.get_file_name("node_buffers_reopened");
+            const int n = 2000;
+            {
+                btree::volume::Volume<int32_t, int32_t> volume(reopened_path, order, test_utils::with_node_buffers(16));
+                for (int i = 0; i < n; ++i)
+                    volume.set((i * 7919) % n, i);
+            }
+            for (int round = 0; round < 2; ++round) {
+                btree::volume::Volume<int32_t, int32_t> volume(reopened_path, order, test_utils::with_node_buffers(16));
+                success &= volume.remove(round);
+                int scanned = 0;
+                volume.scan(0, n, [&scanned](const int32_t, const int32_t) { ++scanned; });
+                success &= (scanned == n - round - 1) && !volume.exist(round);
+            }
+        }
+
+        // the node layout depends on the buffer size, so the volume can't be opened with another one
+        const auto& path = fixture.get_file_name("node_buffers_i32");
+        details::StorageT s;
+        try {
+            s.open_volume(path, order, test_utils::with_node_buffers(2));
+            success = false;
+        } catch (const std::logic_error& e) {
+            std::string_view err_msg = e.what();
+            success &= err_msg.find(error_msg::wrong_buffer_size_msg) != std::string_view::npos;
+        }
+        return success;
+    }
+
+    bool test_volume_ttl() {
+        using namespace std::chrono_literals;
+        const auto& path = fixture.get_file_name("volume_ttl");
+        const int n = 1000;
+        bool success = true;
+        {
+            // odd keys never expire, even keys expire soon, the key N expires in an hour
+            btree::volume::Volume<int32_t, std::string> volume(path, order, test_utils::with_ttl(1h));
+            for (int i = 0; i < n; ++i) {
+                if (i % 2)
+                    volume.set(i, std::to_string(i));
+                else
+                    volume.set(i, std::to_string(i), 50ms);
+            }
+            volume.set(n, std::to_string(n), 1h);
+            // the plain set makes the key persistent
+            volume.set(0, std::to_string(0));
+            for (int i = 0; i <= n; ++i)
+                success &= volume.get(i) == std::to_string(i);
+
+            std::this_thread::sleep_for(100ms);
+            int64_t removed = 0;
+            for (int i = 0; i < 100; ++i)
+                removed += volume.expire_cycle();
+            success &= (removed == n / 2 - 1);
+
+            int scanned = 0;
+            volume.scan(0, n, [&scanned](const int32_t key, const std::string&) {
+                scanned += (key % 2 || key == 0 || key == n);
+            });
+            success &= (scanned == n / 2 + 2);
+            success &= !volume.exist(2) && !volume.remove(2) && volume.exist(1) && volume.exist(0);
+        }
+        {
+            btree::volume::Volume<int32_t, std::string> volume(path, order, test_utils::with_ttl(1h));
+            for (int i = 0; i <= n; ++i)
+                success &= volume.get(i).has_value() == (i % 2 || i == 0 || i == n);
+
+            // the lazy expiration
+            volume.set(n + 1, "expired", 0ms);
+            success &= !volume.exist(n + 1) && !volume.get(n + 1).has_value() && !volume.remove(n + 1);
+        }
+
+        // the entry layout depends on TTL, so the volume can't be opened without it
+        success &= details::open_to_fail<int32_t, std::string>(path, error_msg::wrong_flags_msg);
+        details::StorageT s;
+        auto volume = s.open_volume(fixture.get_file_name("volume_without_ttl"), order);
+        try {
+            volume.set(key, value, 1h);
+            success = false;
+        } catch (const std::logic_error& e) {
+            std::string_view err_msg = e.what();
+            success &= err_msg.find(error_msg::ttl_is_disabled_msg) != std::string_view::npos;
+        }
+        return success;
+    }
+
+    bool test_volume_expiry_index() {
+        using namespace std::chrono_literals;
+        const auto& path = fixture.get_file_name("volume_expiry_index");
+        const int n = 10000;
+        bool success = true;
+        {
+            // the records are popped in the order of { EXPIRES_AT, KEY }, the duplicates are popped once
+            btree::ttl::ExpiryIndex<int64_t> index(path + ".records");
+            success &= !index.is_synced_with(0);
+            index.open();
+            for (int i = n - 1; i >= 0; --i)
+                index.insert(i % 10, i);
+            index.insert(5, 5);
+            index.close(42);
+            index.insert(5, 5);
+            index.insert(100, 0);
+            index.erase(100, 0);
+            // the merged records are erased in the file
+            index.erase(3, 3);
+            index.erase(9, 9);
+            index.erase(9, 9);
+
+            int64_t prev_expires_at = 0, prev_key = -1;
+            int64_t popped = index.pop_expired(4, n, [&](const int64_t key, const int64_t expires_at) {
+                success &= (expires_at > prev_expires_at) || (expires_at == prev_expires_at && key > prev_key);
+                success &= (key % 10 == expires_at) && (key != 3);
+                prev_expires_at = expires_at;
+                prev_key = key;
+            });
+            success &= (popped == n / 2 - 1) && (index.size() == n / 2);
+            index.close(43);
+        }
+        {
+            btree::ttl::ExpiryIndex<int64_t> index(path + ".records");
+            success &= index.is_synced_with(43) && (index.size() == n / 2 - 1);
+            index.open();
+            success &= index.pop_expired(100, 10, [](const int64_t, const int64_t) {}) == 10;
+        }
+        {
+            // the index wasn't closed
+            btree::ttl::ExpiryIndex<int64_t> index(path + ".records");
+            success &= !index.is_synced_with(43);
+        }
+        {
+            // the keys that share one deadline are removed in one cycle
+            btree::volume::Volume<int64_t, int64_t> volume(path, order, test_utils::with_ttl(1h));
+            for (int i = 0; i < n; ++i)
+                volume.set(i, i, (i < n - 100) ? 50ms : 1h);
+        }
+        {
+            btree::volume::Volume<int64_t, int64_t> volume(path, order, test_utils::with_ttl(1h));
+            std::this_thread::sleep_for(100ms);
+            success &= (volume.expire_cycle() == n - 100) && (volume.expire_cycle() == 0);
+            for (int i = 0; i < n; ++i)
+                success &= volume.exist(i) == (i >= n - 100);
+        }
+        return success;
+    }
+
+    bool test_volume_mt_ttl() {
+        using namespace std::chrono_literals;
+        const auto& path = fixture.get_file_name("volume_mt_ttl");
+        const int n = 1000;
+
+        btree::StorageMT<int64_t, double> s;
+        auto volume = s.open_volume(path, order, test_utils::with_ttl(5ms));
+        for (int i = 0; i < n; ++i)
+            volume.set(i, i * 0.5, (i % 2) ? 1h : 10ms);
+
+        // the background expire cycle removes the keys that nobody accesses
+        std::this_thread::sleep_for(200ms);
+        int scanned = 0;
+        volume.scan(0, n, [&scanned](const int64_t key, const double value) {
+            scanned += (key % 2) && (value == key * 0.5);
+        });
+        bool success = (scanned == n / 2);
+        for (int i = 0; i < n; ++i)
+            success &= volume.exist(i) == (i % 2 == 1);
+        s.close_volume(volume);
+        return success;
+    }
 }
 #endif // UNIT_TESTS
\ No newline at end of file